@@ -1,16 +1,21 @@
 
 #include "des.h"
+#include "des_trace.h"
+
+/* Static Functions Declarations --------------------------------------------*/
+template<typename trace_t>
+static bitset<64> des_process_block(const bitset<64>& message, const des_key_t& key_context, bool decrypt, trace_t& trace);
 
 /* Function Definitions -----------------------------------------------------*/
-bitset<48>* sub_key_generator(const bitset<64>& key, bool show_steps) {
+template<typename trace_t>
+void sub_key_generator(const bitset<64>& key, bitset<48> subkeys[DES_ROUNDS], trace_t& trace) {
 
     /* The PC-1 table is used to permute the key bits before splitting it into two halves. */
     bitset<56> pc1_permuted, c_d;
     bitset<28> c[DES_ROUNDS + 1], d[DES_ROUNDS + 1];
-    static bitset<48> subkeys[16];
 
     /* The PC-1 table is used to permute the key bits before splitting it into two halves. */
-    pc1_permuted = permute<64, 56>(key, PC1);
+    pc1_permuted = permute<64, 56, PC1>(key);
 
     /* Split the permuted key into two halves: C and D. */
     for (uint8_t i = 0; i < 28; ++i) {
@@ -18,26 +23,15 @@ bitset<48>* sub_key_generator(const bitset<64>& key, bool show_steps) {
         d[0][27 - i] = pc1_permuted[27 - i];
     }
 
-    if (show_steps) {
-        cout << "\n------------------ Sub Keys Generation -----------------" << endl
-             << "\nKey: " << key << endl
-             << "Permuted Key(PC-1): " << pc1_permuted << endl
-             << "\nSplit into C and D, and apply left shifts:"
-             << "\nC0: " << c[0] << "  D0: " << d[0] << endl;
-    }
+    trace.key_schedule_begin(key, pc1_permuted, c[0], d[0]);
 
     /* Apply the left shifts and generate the subkeys. */
     for (uint8_t i = 0; i < DES_ROUNDS; i++) {
         apply_iterations_left_shift(c[i], d[i], c[i + 1], d[i + 1], ITERATIONS_LEFT_SHIFT[i]);
-
-        if (show_steps) {
-            cout << "C" << (int)i + 1 << ": " << c[i + 1] << "  D" << (int)i + 1 << ": " << d[i + 1] << endl;
-        }
+        trace.key_shift(i, c[i + 1], d[i + 1]);
     }
 
-    if (show_steps) {
-        cout << "\nConcatenate C and D and apply PC-2: " << endl;
-    }
+    trace.key_compression_begin();
 
     /* The PC-2 table is used to permute the combined C and D halves into the final subkey. */
     for (uint8_t i = 0; i < DES_ROUNDS; i++) {
@@ -51,13 +45,9 @@ bitset<48>* sub_key_generator(const bitset<64>& key, bool show_steps) {
         }
 
         /* Apply the PC-2 permutation to the combined C and D halves. */
-        subkeys[i] = permute<56, 48>(c_d, PC2);
-
-        if (show_steps) {
-            cout << "Subkey " << (int)i + 1 << ": " << subkeys[i] << endl;
-        }
+        subkeys[i] = permute<56, 48, PC2>(c_d);
+        trace.subkey(i, subkeys[i]);
     }
-    return subkeys;
 }
 
 void apply_iterations_left_shift(bitset<28>& c_in, bitset<28>& d_in, bitset<28>& c_out, bitset<28>& d_out, const uint8_t number_of_shifts) {
@@ -70,7 +60,8 @@ void apply_iterations_left_shift(bitset<28>& c_in, bitset<28>& d_in, bitset<28>&
     d_out = (d_in << number_of_shifts) | d_lost_bits;
 }
 
-bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, bool show_steps) {
+template<typename trace_t>
+bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, trace_t& trace) {
     bitset<48> expanded_r, xor_result;
     bitset<6> b[8];
     bitset<4> sbox_result[8];
@@ -78,15 +69,11 @@ bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, bool show_steps)
     bitset<4> column;
     bitset<32> sbox_result_concatenated;
 
-    expanded_r = permute<32, 48>(r, E);
+    expanded_r = permute<32, 48, E>(r);
 
     xor_result = expanded_r ^ k;
 
-    if (show_steps) {
-        cout << rang::fg::magenta << "\n---------------- Function f --------------" << rang::style::reset << endl
-             << "Expanded R: " << expanded_r << endl
-             << "XOR with K: " << xor_result << endl;
-    }
+    trace.function_f_begin(expanded_r, xor_result);
 
     for (uint8_t i = 0; i < 8; i++) {
         for (uint8_t j = 0; j < 6; j++) {
@@ -101,11 +88,7 @@ bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, bool show_steps)
         column[3] = b[i][4];
 
         sbox_result[i] = S_BOXES[i][row.to_ullong()][column.to_ullong()];
-
-        if (show_steps) {
-            cout << "S" << (int)i + 1 << " Row: " << row.to_ullong() << " Column: " << column.to_ullong() << 
-            " Value: " << sbox_result[i] << endl;
-        }
+        trace.sbox(i, row.to_ullong(), column.to_ullong(), sbox_result[i]);
     }
 
     for (uint8_t i = 0; i < 8; i++) {
@@ -114,17 +97,105 @@ bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, bool show_steps)
         }
     }
 
-    if (show_steps) {
-        cout << "\nApply the P permutation to the concatenated S-Box result: " << endl;
-    }
+    trace.function_f_end();
 
     /* Apply the P permutation to the concatenated S-Box result. */
 
-    sbox_result_concatenated = permute<32, 32>(sbox_result_concatenated, P);
+    sbox_result_concatenated = permute<32, 32, P>(sbox_result_concatenated);
 
     return sbox_result_concatenated;
 }
 
+template<typename trace_t>
+void des_key_setup(des_key_t& key_context, const bitset<64>& key, trace_t& trace) {
+    /* The schedule is written straight into the caller's context: no shared state, no heap. */
+    sub_key_generator(key, key_context.subkeys, trace);
+}
+
+template<typename trace_t>
+bitset<64> des_encrypt_block(const bitset<64>& message, const des_key_t& key_context, trace_t& trace) {
+    return des_process_block(message, key_context, false, trace);
+}
+
+template<typename trace_t>
+bitset<64> des_decrypt_block(const bitset<64>& ciphertext, const des_key_t& key_context, trace_t& trace) {
+    return des_process_block(ciphertext, key_context, true, trace);
+}
+
+bitset<32> function_f(const bitset<32>& r, const bitset<48>& k) {
+    des_no_trace_t trace;
+    return function_f(r, k, trace);
+}
+
+void sub_key_generator(const bitset<64>& key, bitset<48> subkeys[DES_ROUNDS]) {
+    des_no_trace_t trace;
+    sub_key_generator(key, subkeys, trace);
+}
+
+void des_key_setup(des_key_t& key_context, const bitset<64>& key) {
+    des_no_trace_t trace;
+    sub_key_generator(key, key_context.subkeys, trace);
+}
+
+bitset<64> des_encrypt_block(const bitset<64>& message, const des_key_t& key_context) {
+    des_no_trace_t trace;
+    return des_process_block(message, key_context, false, trace);
+}
+
+bitset<64> des_decrypt_block(const bitset<64>& ciphertext, const des_key_t& key_context) {
+    des_no_trace_t trace;
+    return des_process_block(ciphertext, key_context, true, trace);
+}
+
+template<typename trace_t>
+static bitset<64> des_process_block(const bitset<64>& message, const des_key_t& key_context, bool decrypt, trace_t& trace) {
+    bitset<64> r_16_l_16_concatenated, ip_permuted;
+    bitset<32> l[DES_ROUNDS + 1], r[DES_ROUNDS + 1], function_f_result;
+
+    /* Apply the initial permutation (IP) to the message.*/ 
+    ip_permuted = permute<64, 64, IP>(message);
+
+    /* Split the permuted message into two halves: left (l) and right (r). */
+    for (uint8_t i = 0; i < 32; ++i) {
+        l[0][31 - i] = ip_permuted[63 - i];
+        r[0][31 - i] = ip_permuted[31 - i];
+    }
+
+    /* Apply the 16 rounds of the DES algorithm. */
+    /* Decryption is the same network with the subkeys applied in reverse order (K16 first). */
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        uint8_t k = decrypt ? (DES_ROUNDS - 1 - i) : i;
+
+        trace.round_begin(i, k, key_context.subkeys[k]);
+
+        function_f_result = function_f(r[i], key_context.subkeys[k], trace);
+        l[i + 1] = r[i];
+        r[i + 1] = l[i] ^ function_f_result;    /* R1 = L0 + f(R0,K1)  */
+        trace.round_end(i, k, function_f_result, l[i + 1], r[i + 1]);
+    }
+
+    /* Concatenate the last round's right and left halves. */
+    /* The left half (l) is placed in the lower 32 bits, and the right half (r) is placed in the upper 32 bits. */
+    for (uint8_t i = 0; i < 32; i++) {
+        r_16_l_16_concatenated[63 - i] = r[DES_ROUNDS][31 - i];
+        r_16_l_16_concatenated[31 - i] = l[DES_ROUNDS][31 - i];
+    }
+
+    /* Apply the final permutation (IP-1) to the concatenated result. */
+    return permute<64, 64, IP_INV>(r_16_l_16_concatenated);
+}
+
+/* Explicit Instantiations --------------------------------------------------*/
+#define DES_TRACE_INSTANTIATE(trace_t) \
+    template void sub_key_generator<trace_t>(const bitset<64>&, bitset<48>[DES_ROUNDS], trace_t&); \
+    template bitset<32> function_f<trace_t>(const bitset<32>&, const bitset<48>&, trace_t&); \
+    template void des_key_setup<trace_t>(des_key_t&, const bitset<64>&, trace_t&); \
+    template bitset<64> des_encrypt_block<trace_t>(const bitset<64>&, const des_key_t&, trace_t&); \
+    template bitset<64> des_decrypt_block<trace_t>(const bitset<64>&, const des_key_t&, trace_t&);
+
+DES_TRACE_INSTANTIATE(des_no_trace_t)
+DES_TRACE_INSTANTIATE(des_record_trace_t)
+
 void print_binary(const uint64_t number, const uint8_t number_of_bits) {
     for (int i = number_of_bits - 1; i >= 0; --i) {
         cout << ((number >> i) & 1);
@@ -136,15 +207,15 @@ void print_binary(const uint64_t number, const uint8_t number_of_bits) {
 }
 
 
-void print_block(const bitset<64>& plaintext, const bitset<64>& key, const bitset<64>& ciphertext) {
-    cout << rang::fg::yellow << "\n================ DES Encryption =================" << rang::style::reset << endl;
+void print_block(const bitset<64>& input, const bitset<64>& key, const bitset<64>& output, bool decrypt) {
+    cout << rang::fg::yellow << (decrypt ? "\n================ DES Decryption =================" : "\n================ DES Encryption =================") << rang::style::reset << endl;
 
     cout << "\n" << rang::fg::magenta << ">>> Input:" << rang::style::reset << endl;
 
-    cout << rang::fg::cyan << "Plaintext : " << rang::style::reset;
-    print_binary(plaintext.to_ullong(), 64);
+    cout << rang::fg::cyan << (decrypt ? "Ciphertext: " : "Plaintext : ") << rang::style::reset;
+    print_binary(input.to_ullong(), 64);
     cout << rang::fg::green <<"\t    0x"
-         << uppercase << hex << plaintext.to_ullong()
+         << uppercase << hex << input.to_ullong()
          << rang::style::reset << dec << endl << endl;
 
     cout << rang::fg::cyan << "Key       : " << rang::style::reset;
@@ -155,10 +226,10 @@ void print_block(const bitset<64>& plaintext, const bitset<64>& key, const bitse
 
     cout << rang::fg::magenta << "\n>>> Output:" << rang::style::reset << endl;
 
-    cout << rang::fg::cyan << "Ciphertext: " << rang::style::reset;
-    print_binary(ciphertext.to_ullong(), 64);
+    cout << rang::fg::cyan << (decrypt ? "Plaintext : " : "Ciphertext: ") << rang::style::reset;
+    print_binary(output.to_ullong(), 64);
     cout << rang::fg::green <<"\t    0x"
-        << uppercase << hex << ciphertext.to_ullong()
+        << uppercase << hex << output.to_ullong()
         << rang::style::reset << dec << endl << endl;
 
     cout << rang::fg::yellow << "\n=================================================\n" << rang::style::reset << endl;
@@ -13,39 +13,53 @@
 #include <iostream>
 #include <bitset>
 #include <rang.hpp>
+#include "des_tables.h"
+#include "des_permute.h"
 
 using namespace std;
 
 /* Macro Declarations -------------------------------------------------------*/
 #define DES_ROUNDS      16
 
-/* Variables Declarations ---------------------------------------------------*/
-extern const uint8_t PC1[64];
-extern const uint8_t ITERATIONS_LEFT_SHIFT[16];
-extern const uint8_t PC2[48];
-extern const uint8_t IP[64];
-extern const uint8_t IP_INV[64];
-extern const uint8_t E[48];
-extern const uint8_t S_BOXES[8][4][16];
-extern const uint8_t P[32];
+/* Data Type Declarations -------------------------------------------------*/
+/* Key context: the expanded key schedule of one DES key, built once and reused for any number of blocks. */
+typedef struct {
+    bitset<48> subkeys[DES_ROUNDS];
+} des_key_t;
 
 /* Functions Declarations ---------------------------------------------------*/
-template<uint8_t input_size, uint8_t output_size>
-bitset<output_size> permute(const bitset<input_size> input, const uint8_t table[output_size]) {
-    bitset<output_size> output;
-    for (uint8_t i = 0; i < output_size; i++) {
-        output[output_size - i - 1] = input[input_size - table[i]];
-    }
-    return output;
+/* Output bit i + 1 is input bit table[i]. The table is a template argument so that it is
+ * compiled into a few shifts (or PEXT/PDEP) per call, see des_permute.h. */
+template<uint8_t input_size, uint8_t output_size, const uint8_t (&table)[output_size]>
+bitset<output_size> permute(const bitset<input_size>& input) {
+    return bitset<output_size>(permute_word<input_size, output_size, table>(input.to_ullong()));
 }
 
-bitset<48>* sub_key_generator(const bitset<64>& key, bool show_steps);
+/* The step-by-step functions take a trace policy (see des_trace.h) whose hooks are called at
+ * every step; they are instantiated for des_no_trace_t and des_record_trace_t. */
+template<typename trace_t>
+void sub_key_generator(const bitset<64>& key, bitset<48> subkeys[DES_ROUNDS], trace_t& trace);
 void apply_iterations_left_shift(bitset<28>& c_in, bitset<28>& d_in, bitset<28>& c_out, bitset<28>& d_out, const uint8_t number_of_shifts);
 
 void print_binary(const uint64_t number, const uint8_t number_of_bits);
 
-bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, bool show_steps);
+template<typename trace_t>
+bitset<32> function_f(const bitset<32>& r, const bitset<48>& k, trace_t& trace);
 
-void print_block(const bitset<64>& plaintext, const bitset<64>& key, const bitset<64>& ciphertext) ;
+template<typename trace_t>
+void des_key_setup(des_key_t& key_context, const bitset<64>& key, trace_t& trace);
+template<typename trace_t>
+bitset<64> des_encrypt_block(const bitset<64>& message, const des_key_t& key_context, trace_t& trace);
+template<typename trace_t>
+bitset<64> des_decrypt_block(const bitset<64>& ciphertext, const des_key_t& key_context, trace_t& trace);
+
+/* Untraced entry points. */
+bitset<32> function_f(const bitset<32>& r, const bitset<48>& k);
+void sub_key_generator(const bitset<64>& key, bitset<48> subkeys[DES_ROUNDS]);
+void des_key_setup(des_key_t& key_context, const bitset<64>& key);
+bitset<64> des_encrypt_block(const bitset<64>& message, const des_key_t& key_context);
+bitset<64> des_decrypt_block(const bitset<64>& ciphertext, const des_key_t& key_context);
+
+void print_block(const bitset<64>& input, const bitset<64>& key, const bitset<64>& output, bool decrypt);
 
 #endif	/* DES_H */
\ No newline at end of file
@@ -0,0 +1,416 @@
+/**
+ ******************************************************************************
+ * \file       des_bench.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      Benchmarks for the des engines
+ * \details    Measures key-setup latency, single-block latency and bulk throughput of every
+ *             engine across buffer sizes and thread counts. Results are printed one per line
+ *             as CSV (default) or JSON lines so runs can be diffed and tracked over time.
+ *             Multi-key results also carry keys/s, the figure that matters for key agility.
+ *             cycles/byte is derived from the time-stamp counter on x86 and is 0 elsewhere.
+ *             With --dudect it instead runs a dudect-style leakage test: Welch's t-test on
+ *             the timings of fixed against random keys and blocks, per engine.
+ ******************************************************************************
+*/
+#include "des.h"
+#include "des_fast.h"
+#include "des_bitslice.h"
+#include "des_modes.h"
+#include "des_codec.h"
+#include "des_thread_pool.h"
+#include "des_key_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DES_BENCH_TSC
+#endif
+
+/* Macro Declarations -------------------------------------------------------*/
+/* Timings are taken in batches with the classes interleaved at random. Besides the full set,
+ * the t-test runs on the timings below DES_DUDECT_CROPS increasing percentiles, which cuts
+ * off interrupts and other noise that only ever makes a run slower. */
+#define DES_DUDECT_BATCH        10000
+#define DES_DUDECT_CROPS        20
+
+/* |t| above this is evidence that the timing depends on the class, i.e. on the secret. */
+#define DES_DUDECT_THRESHOLD    4.5
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef struct {
+    string engine;
+    string operation;
+    size_t bytes;           /* bytes processed per operation, 0 for latency-only results */
+    size_t threads;
+    uint64_t iterations;
+    double ns_per_op;
+    uint64_t cycles_per_op;
+    size_t keys;            /* distinct keys used per operation, 0 for single-key results */
+} bench_result_t;
+
+/* Welch's t-test accumulated online (Welford) over two classes. */
+typedef struct {
+    double n[2];
+    double mean[2];
+    double m2[2];
+} welch_test_t;
+
+/* Variables Definitions ----------------------------------------------------*/
+static bool json_output = false;
+static double min_seconds = 0.2;
+static volatile uint64_t sink;
+
+/* Static Functions Declarations --------------------------------------------*/
+static inline uint64_t read_cycles();
+template<typename op_t>
+static bench_result_t measure(const string& engine, const string& operation, size_t bytes, size_t threads, op_t op);
+static void report(const bench_result_t& result);
+static void report_keys(bench_result_t result, size_t keys);
+static inline uint64_t read_timer();
+static void welch_push(welch_test_t& test, const uint8_t group, const double x);
+static double welch_t(const welch_test_t& test);
+template<typename op_t>
+static double dudect(const string& engine, const uint64_t measurements, op_t op);
+static void print_usage(const char* program_name);
+
+/* Main Function ------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes = { 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+    vector<size_t> thread_counts = { 1 };
+    size_t max_threads = thread::hardware_concurrency();
+    uint64_t dudect_measurements = 0;
+    const uint64_t key = 0x133457799BBCDFF1ULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--json") {
+            json_output = true;
+        }
+        else if (string(argv[i]) == "--min-time" && i + 1 < argc) {
+            min_seconds = stod(argv[++i]);
+        }
+        else if (string(argv[i]) == "--max-threads" && i + 1 < argc) {
+            max_threads = stoul(argv[++i]);
+        }
+        else if (string(argv[i]) == "--dudect") {
+            dudect_measurements = (i + 1 < argc && isdigit(argv[i + 1][0])) ? stoull(argv[++i]) : 1000000;
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (dudect_measurements > 0) {
+        /* Key setup plus one block, so both the schedule and the rounds are covered. The
+         * constant-time engine must pass; the table engine is there for comparison. */
+        if (!json_output) {
+            cout << "engine,measurements,max_t,verdict" << endl;
+        }
+        dudect("fast", dudect_measurements, [](uint64_t k, uint64_t block) {
+            des_fast_key_t context;
+            des_fast_key_setup(context, k);
+            return des_fast_encrypt_block(block, context);
+        });
+        double ct_t = dudect("ct", dudect_measurements, [](uint64_t k, uint64_t block) {
+            des_fast_key_t context;
+            des_fast_key_setup_ct(context, k);
+            des_bitslice_encrypt_blocks(&block, &block, 1, context);
+            return block;
+        });
+        return (ct_t < DES_DUDECT_THRESHOLD) ? 0 : 1;
+    }
+
+    for (size_t t = 2; t <= max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    if (max_threads > 1 && thread_counts.back() != max_threads) {
+        thread_counts.push_back(max_threads);
+    }
+
+    if (!json_output) {
+        cout << "engine,operation,bytes,threads,iterations,ns_per_op,mb_per_s,cycles_per_byte,keys_per_s" << endl;
+    }
+
+    /* Building blocks of the reference engine. */
+    bitset<64> block(0x0123456789ABCDEFULL), reference_key(key);
+    bitset<48> subkey(0x1B02EFFC7072ULL), subkeys[DES_ROUNDS];
+    report(measure("reference", "permute_ip", 8, 1, [&] { block = permute<64, 64, IP>(block); }));
+    report(measure("reference", "function_f", 4, 1, [&] { sink = function_f(bitset<32>(sink), subkey).to_ulong(); }));
+    report(measure("reference", "sub_key_generator", 0, 1, [&] { sub_key_generator(reference_key, subkeys); }));
+
+    /* Key setup latency. */
+    des_key_t key_context;
+    des_fast_key_t fast_key_context;
+    des3_fast_key_t key3_context;
+    report(measure("reference", "key_setup", 0, 1, [&] { des_key_setup(key_context, reference_key); }));
+    report(measure("fast", "key_setup", 0, 1, [&] { des_fast_key_setup(fast_key_context, sink ^ key); }));
+    report(measure("3des", "key_setup", 0, 1, [&] { des3_fast_key_setup(key3_context, key, ~key, sink ^ key); }));
+
+    /* A cache hit, cycling through 16 hot keys. */
+    des_key_cache key_cache(DES_KEY_CACHE_ENTRIES);
+    size_t lookups = 0;
+    report(measure("cached", "key_setup", 0, 1, [&] { key_cache.get(key ^ (lookups++ & 0x0F), fast_key_context); }));
+    des_fast_key_setup(fast_key_context, key);
+    des3_fast_key_setup(key3_context, key, ~key, key ^ 0x0101010101010101ULL);
+
+    /* Single-block latency: each block depends on the previous result. */
+    uint64_t x = 0x0123456789ABCDEFULL;
+    report(measure("reference", "block", 8, 1, [&] { block = des_encrypt_block(block, key_context); }));
+    report(measure("fast", "block", 8, 1, [&] { x = des_fast_encrypt_block(x, fast_key_context); }));
+    report(measure("3des", "block", 8, 1, [&] { x = des3_fast_encrypt_block(x, key3_context); }));
+    report(measure("bitslice", "block", 8, 1, [&] { des_bitslice_encrypt_blocks(&x, &x, 1, fast_key_context); }));
+    sink = x;
+
+    /* Bulk throughput of the raw engines. */
+    vector<uint64_t> blocks(sizes.back() / DES_BLOCK_BYTES, 0x0123456789ABCDEFULL);
+    for (size_t bytes : sizes) {
+        size_t n = bytes / DES_BLOCK_BYTES;
+
+        report(measure("fast", "bulk", bytes, 1, [&] {
+            for (size_t i = 0; i < n; i++) {
+                blocks[i] = des_fast_encrypt_block(blocks[i], fast_key_context);
+            }
+        }));
+
+        for (des_bitslice_kernel_t kernel : { DES_BITSLICE_KERNEL_SCALAR, DES_BITSLICE_KERNEL_AVX2, DES_BITSLICE_KERNEL_AVX512 }) {
+            if (des_bitslice_set_kernel(kernel)) {
+                report(measure(string("bitslice_") + des_bitslice_kernel_name(kernel), "bulk", bytes, 1, [&] {
+                    des_bitslice_encrypt_blocks(blocks.data(), blocks.data(), n, fast_key_context);
+                }));
+            }
+        }
+        des_bitslice_set_kernel(DES_BITSLICE_KERNEL_AUTO);
+    }
+
+    /* Text codecs used by batch mode, per 8192 blocks; bytes counts the text side. */
+    const size_t codec_blocks = 8192;
+    vector<char> text(codec_blocks * DES_HEX_BLOCK_CHARS);
+    for (des_codec_t codec : { DES_CODEC_HEX, DES_CODEC_BASE64 }) {
+        size_t chars = des_codec_block_chars(codec);
+        string engine = (codec == DES_CODEC_HEX) ? "hex" : "base64";
+
+        report(measure(engine, "encode", codec_blocks * chars, 1, [&] {
+            for (size_t i = 0; i < codec_blocks; i++) {
+                des_codec_encode_block(codec, blocks[i], text.data() + (i * chars));
+            }
+        }));
+        report(measure(engine, "decode", codec_blocks * chars, 1, [&] {
+            for (size_t i = 0; i < codec_blocks; i++) {
+                sink += des_codec_decode_block(codec, text.data() + (i * chars), blocks[i]);
+            }
+        }));
+    }
+
+    /* Key agility: a fresh key every one or two blocks, per-key setup against the bitsliced
+     * key schedule. */
+    const size_t key_count = 4096;
+    vector<uint64_t> keys(key_count);
+    for (size_t i = 0; i < key_count; i++) {
+        keys[i] = key ^ (i * 0x9E3779B97F4A7C15ULL);
+    }
+    for (size_t blocks_per_key : { 1, 2 }) {
+        size_t n = key_count * blocks_per_key;
+        string operation = "multi_key_" + to_string(blocks_per_key);
+
+        report_keys(measure("fast", operation, n * DES_BLOCK_BYTES, 1, [&] {
+            for (size_t k = 0; k < key_count; k++) {
+                des_fast_key_setup(fast_key_context, keys[k]);
+                for (size_t j = k * blocks_per_key; j < (k + 1) * blocks_per_key; j++) {
+                    blocks[j] = des_fast_encrypt_block(blocks[j], fast_key_context);
+                }
+            }
+        }), key_count);
+
+        for (des_bitslice_kernel_t kernel : { DES_BITSLICE_KERNEL_SCALAR, DES_BITSLICE_KERNEL_AVX2, DES_BITSLICE_KERNEL_AVX512 }) {
+            if (des_bitslice_set_kernel(kernel)) {
+                report_keys(measure(string("bitslice_") + des_bitslice_kernel_name(kernel), operation, n * DES_BLOCK_BYTES, 1, [&] {
+                    des_multi_key_encrypt(keys.data(), key_count, blocks.data(), blocks_per_key, blocks.data());
+                }), key_count);
+            }
+        }
+        des_bitslice_set_kernel(DES_BITSLICE_KERNEL_AUTO);
+    }
+    des_fast_key_setup(fast_key_context, key);
+
+    /* Modes over byte buffers, across thread counts. */
+    vector<uint8_t> buffer(sizes.back() + DES_BLOCK_BYTES, 0x5A);
+    for (size_t threads : thread_counts) {
+        des_set_thread_count(threads);
+
+        for (size_t bytes : sizes) {
+            for (const char* name : { "ecb", "cbc", "ctr" }) {
+                des_mode_t mode;
+                des_mode_from_string(name, mode);
+
+                report(measure(string("des_") + name, "encrypt", bytes, threads, [&] {
+                    des_stream_t stream = { mode, 0 };
+                    des_stream_encrypt_blocks(stream, fast_key_context, buffer.data(), buffer.data(), bytes / DES_BLOCK_BYTES);
+                }));
+            }
+            report(measure("des_cbc", "decrypt", bytes, threads, [&] {
+                des_stream_t stream = { DES_MODE_CBC, 0 };
+                des_stream_decrypt_blocks(stream, fast_key_context, buffer.data(), buffer.data(), bytes / DES_BLOCK_BYTES);
+            }));
+            report(measure("3des_ctr", "encrypt", bytes, threads, [&] {
+                des_stream_t stream = { DES_MODE_CTR, 0 };
+                des_stream_encrypt_blocks(stream, key3_context, buffer.data(), buffer.data(), bytes / DES_BLOCK_BYTES);
+            }));
+        }
+    }
+
+    return 0;
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static inline uint64_t read_cycles() {
+#ifdef DES_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* Run op in growing batches until min_seconds have elapsed and report the per-op averages. */
+template<typename op_t>
+static bench_result_t measure(const string& engine, const string& operation, size_t bytes, size_t threads, op_t op) {
+    uint64_t iterations = 0, batch = 1, cycles = 0;
+    double seconds = 0;
+
+    op();
+    while (seconds < min_seconds) {
+        auto start = chrono::steady_clock::now();
+        uint64_t start_cycles = read_cycles();
+
+        for (uint64_t i = 0; i < batch; i++) {
+            op();
+        }
+
+        cycles += read_cycles() - start_cycles;
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        iterations += batch;
+        batch *= 2;
+    }
+
+    return { engine, operation, bytes, threads, iterations, (seconds * 1e9) / iterations, cycles / iterations, 0 };
+}
+
+static void report(const bench_result_t& result) {
+    double mb_per_s = (result.bytes == 0) ? 0 : (result.bytes * 1e3) / result.ns_per_op;
+    double cycles_per_byte = (result.bytes == 0) ? 0 : static_cast<double>(result.cycles_per_op) / result.bytes;
+    double keys_per_s = (result.keys * 1e9) / result.ns_per_op;
+
+    if (json_output) {
+        cout << "{\"engine\":\"" << result.engine << "\",\"operation\":\"" << result.operation
+             << "\",\"bytes\":" << result.bytes << ",\"threads\":" << result.threads
+             << ",\"iterations\":" << result.iterations << ",\"ns_per_op\":" << result.ns_per_op
+             << ",\"mb_per_s\":" << mb_per_s << ",\"cycles_per_byte\":" << cycles_per_byte << ",\"keys_per_s\":" << keys_per_s << "}" << endl;
+    }
+    else {
+        cout << result.engine << "," << result.operation << "," << result.bytes << "," << result.threads << ","
+             << result.iterations << "," << result.ns_per_op << "," << mb_per_s << "," << cycles_per_byte << "," << keys_per_s << endl;
+    }
+}
+
+static void report_keys(bench_result_t result, size_t keys) {
+    result.keys = keys;
+    report(result);
+}
+
+/* Serialised against the measured code on x86, so the operation cannot start early or finish
+ * late relative to the reading. */
+static inline uint64_t read_timer() {
+#ifdef DES_BENCH_TSC
+    _mm_lfence();
+    uint64_t cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void welch_push(welch_test_t& test, const uint8_t group, const double x) {
+    double delta = x - test.mean[group];
+
+    test.n[group]++;
+    test.mean[group] += delta / test.n[group];
+    test.m2[group] += delta * (x - test.mean[group]);
+}
+
+static double welch_t(const welch_test_t& test) {
+    double variance0 = test.m2[0] / (test.n[0] - 1), variance1 = test.m2[1] / (test.n[1] - 1);
+    return (test.mean[0] - test.mean[1]) / sqrt((variance0 / test.n[0]) + (variance1 / test.n[1]));
+}
+
+/* Time op(key, block) with class 0 on a fixed key and block and class 1 on random ones, and
+ * report the largest |t| over the full and the cropped sets. The inputs are drawn before each
+ * batch so the generator stays out of the timed region. */
+template<typename op_t>
+static double dudect(const string& engine, const uint64_t measurements, op_t op) {
+    const uint64_t fixed_key = 0x133457799BBCDFF1ULL, fixed_block = 0x0123456789ABCDEFULL;
+    mt19937_64 random(0xD0DEC7ULL);
+    vector<uint64_t> keys(DES_DUDECT_BATCH), blocks(DES_DUDECT_BATCH), durations(DES_DUDECT_BATCH);
+    vector<uint8_t> groups(DES_DUDECT_BATCH);
+    welch_test_t tests[DES_DUDECT_CROPS + 1] = {};
+    uint64_t thresholds[DES_DUDECT_CROPS] = {};
+    double max_t = 0;
+
+    /* The first batch only warms up and sets the crop thresholds. */
+    for (uint64_t done = 0, batch = 0; done < measurements; batch++) {
+        for (size_t i = 0; i < DES_DUDECT_BATCH; i++) {
+            groups[i] = random() & 1;
+            keys[i] = groups[i] ? random() : fixed_key;
+            blocks[i] = groups[i] ? random() : fixed_block;
+        }
+        for (size_t i = 0; i < DES_DUDECT_BATCH; i++) {
+            uint64_t start = read_timer();
+            sink = op(keys[i], blocks[i]);
+            durations[i] = read_timer() - start;
+        }
+
+        if (batch == 0) {
+            vector<uint64_t> sorted(durations);
+            sort(sorted.begin(), sorted.end());
+            for (size_t k = 0; k < DES_DUDECT_CROPS; k++) {
+                thresholds[k] = sorted[static_cast<size_t>((1 - pow(0.5, 10.0 * (k + 1) / DES_DUDECT_CROPS)) * DES_DUDECT_BATCH)];
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < DES_DUDECT_BATCH; i++) {
+            welch_push(tests[0], groups[i], static_cast<double>(durations[i]));
+            for (size_t k = 0; k < DES_DUDECT_CROPS; k++) {
+                if (durations[i] < thresholds[k]) {
+                    welch_push(tests[k + 1], groups[i], static_cast<double>(durations[i]));
+                }
+            }
+        }
+        done += DES_DUDECT_BATCH;
+    }
+
+    for (const welch_test_t& test : tests) {
+        if (test.n[0] > 1000 && test.n[1] > 1000) {
+            max_t = max(max_t, fabs(welch_t(test)));
+        }
+    }
+
+    const char* verdict = (max_t < DES_DUDECT_THRESHOLD) ? "no leakage detected" : "leakage";
+    if (json_output) {
+        cout << "{\"engine\":\"" << engine << "\",\"measurements\":" << measurements
+             << ",\"max_t\":" << max_t << ",\"verdict\":\"" << verdict << "\"}" << endl;
+    }
+    else {
+        cout << engine << "," << measurements << "," << max_t << "," << verdict << endl;
+    }
+    return max_t;
+}
+
+static void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name
+         << " --json(optional, default: csv)"
+         << " --min-time <seconds>(optional, default: 0.2)"
+         << " --max-threads <n>(optional, default: all cores)"
+         << " --dudect <measurements>(optional, timing leakage test only, default: 1000000)" << endl;
+}
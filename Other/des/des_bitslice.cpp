@@ -0,0 +1,1051 @@
+/**
+ ******************************************************************************
+ * \file       des_bitslice.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the bitsliced des engine
+ ******************************************************************************
+*/
+#include "des_bitslice.h"
+#include <atomic>
+#include <cstring>
+
+/* Macro Declarations -------------------------------------------------------*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DES_BITSLICE_X86
+#endif
+
+#ifdef __GNUC__
+#define DES_BITSLICE_INLINE     inline __attribute__((always_inline))
+#else
+#define DES_BITSLICE_INLINE     inline
+#endif
+
+/* Data Type Declarations ---------------------------------------------------*/
+#ifdef DES_BITSLICE_X86
+/* One AVX2 / AVX-512 register holds 4 / 8 lanes of 64 blocks. */
+typedef uint64_t avx2_word_t __attribute__((vector_size(32)));
+typedef uint64_t avx512_word_t __attribute__((vector_size(64)));
+#endif
+
+/* p_inverse[m] is the bit of P's output that S-box output bit m + 1 lands on. */
+typedef struct {
+    uint8_t p_inverse[32];
+} sbox_wiring_t;
+
+static constexpr sbox_wiring_t sbox_wiring_generator() {
+    sbox_wiring_t wiring = {};
+
+    for (uint8_t j = 0; j < 32; j++) {
+        wiring.p_inverse[P[j] - 1] = j;
+    }
+    return wiring;
+}
+
+static void des_bitslice_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt);
+static void des_bitslice_process_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt);
+
+static des_bitslice_kernel_t des_bitslice_kernel_detect();
+
+/* Variables Definitions ----------------------------------------------------*/
+static constexpr sbox_wiring_t sbox_wiring = sbox_wiring_generator();
+static atomic<des_bitslice_kernel_t> active_kernel(des_bitslice_kernel_detect());
+
+/* Static Functions Definitions ---------------------------------------------*/
+/* The S-boxes as straight-line AND / OR / XOR / ANDN / NOT circuits from the six input planes
+ * (x[0] = b1) to the four output planes (out[0] = most significant S-box bit). Each circuit
+ * splits the S-box on one input bit at a time, leaves each half free where the split does not
+ * need it and reuses every gate already built, so the four outputs share most of their terms.
+ * The self-test checks them against S_BOXES through every kernel. */
+
+/* S1, 59 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox1_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = ~x[5];
+    word_t t1 = t0 ^ x[0];
+    word_t t2 = t1 ^ x[3];
+    word_t t3 = x[5] | t2;
+    word_t t4 = t3 & x[4];
+    word_t t5 = t2 ^ t4;
+    word_t t6 = x[4] ^ x[5];
+    word_t t7 = t1 & ~t4;
+    word_t t8 = t7 & x[3];
+    word_t t9 = t6 ^ t8;
+    word_t t10 = t9 & x[2];
+    word_t t11 = t5 ^ t10;
+    word_t t12 = x[2] ^ t2;
+    word_t t13 = t11 & ~x[5];
+    word_t t14 = t12 ^ t13;
+    word_t t15 = x[0] | t9;
+    word_t t16 = t15 & ~x[4];
+    word_t t17 = t14 | t16;
+    word_t t18 = t17 & x[1];
+    word_t t19 = t11 ^ t18;
+    word_t t20 = t6 & x[2];
+    word_t t21 = t17 & ~t20;
+    word_t t22 = t12 & ~x[5];
+    word_t t23 = t9 | t22;
+    word_t t24 = t23 & ~x[0];
+    word_t t25 = t21 ^ t24;
+    word_t t26 = x[3] ^ t5;
+    word_t t27 = t11 & ~x[4];
+    word_t t28 = t26 | t27;
+    word_t t29 = x[0] & ~t22;
+    word_t t30 = t29 & ~x[3];
+    word_t t31 = t28 ^ t30;
+    word_t t32 = t31 & ~x[1];
+    word_t t33 = t25 ^ t32;
+    word_t t34 = x[1] ^ t23;
+    word_t t35 = x[5] & ~x[2];
+    word_t t36 = x[1] & x[0];
+    word_t t37 = t35 | t36;
+    word_t t38 = t37 & ~x[4];
+    word_t t39 = t34 ^ t38;
+    word_t t40 = t3 ^ t19;
+    word_t t41 = t33 | t38;
+    word_t t42 = t41 ^ x[1];
+    word_t t43 = t42 & ~x[2];
+    word_t t44 = t40 ^ t43;
+    word_t t45 = t44 & ~x[3];
+    word_t t46 = t39 ^ t45;
+    word_t t47 = t0 ^ t12;
+    word_t t48 = t5 ^ t25;
+    word_t t49 = t48 & x[4];
+    word_t t50 = t47 ^ t49;
+    word_t t51 = t50 & ~t10;
+    word_t t52 = t3 ^ t41;
+    word_t t53 = t52 | t20;
+    word_t t54 = t46 & ~t25;
+    word_t t55 = t54 & ~x[5];
+    word_t t56 = t53 & ~t55;
+    word_t t57 = t56 & ~x[1];
+    out[1] = t51 ^ t57;
+    out[0] = t46;
+    out[2] = t19;
+    out[3] = t33;
+}
+
+/* S2, 53 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox2_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = ~x[3];
+    word_t t1 = t0 ^ x[4];
+    word_t t2 = t1 ^ x[0];
+    word_t t3 = x[2] ^ t0;
+    word_t t4 = x[4] & x[0];
+    word_t t5 = t3 | t4;
+    word_t t6 = t5 & x[1];
+    word_t t7 = t2 ^ t6;
+    word_t t8 = ~x[1];
+    word_t t9 = x[4] & x[3];
+    word_t t10 = t8 ^ t9;
+    word_t t11 = t10 & ~x[2];
+    word_t t12 = t6 ^ t11;
+    word_t t13 = t12 & x[5];
+    out[1] = t7 ^ t13;
+    word_t t14 = x[4] | t2;
+    word_t t15 = t14 & ~x[1];
+    word_t t16 = t1 ^ t15;
+    word_t t17 = x[0] ^ t15;
+    word_t t18 = t8 & x[3];
+    word_t t19 = t17 | t18;
+    word_t t20 = t19 & ~x[5];
+    word_t t21 = t16 ^ t20;
+    word_t t22 = x[5] ^ t4;
+    word_t t23 = t22 | t20;
+    word_t t24 = t23 & x[2];
+    word_t t25 = t21 ^ t24;
+    word_t t26 = t19 & ~x[1];
+    word_t t27 = x[2] ^ t26;
+    word_t t28 = x[1] | t25;
+    word_t t29 = t28 ^ x[0];
+    word_t t30 = t29 & ~x[5];
+    word_t t31 = t27 ^ t30;
+    word_t t32 = x[3] ^ t20;
+    word_t t33 = t32 ^ t24;
+    word_t t34 = t11 ^ t13;
+    word_t t35 = t34 & x[0];
+    word_t t36 = t33 ^ t35;
+    word_t t37 = t36 & ~x[4];
+    out[3] = t31 ^ t37;
+    word_t t38 = t2 & x[0];
+    word_t t39 = t10 ^ t38;
+    word_t t40 = x[3] | t16;
+    word_t t41 = t40 ^ t6;
+    word_t t42 = t41 & ~x[2];
+    word_t t43 = t39 ^ t42;
+    word_t t44 = x[1] & t7;
+    word_t t45 = t44 ^ t4;
+    word_t t46 = t28 & ~t38;
+    word_t t47 = t46 & x[3];
+    word_t t48 = t45 | t47;
+    word_t t49 = t48 & x[5];
+    out[2] = t43 ^ t49;
+    out[0] = t25;
+}
+
+/* S3, 54 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox3_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[1] ^ x[5];
+    word_t t1 = t0 ^ x[2];
+    word_t t2 = x[3] | x[5];
+    word_t t3 = t2 & x[0];
+    word_t t4 = t1 ^ t3;
+    word_t t5 = x[1] & t1;
+    word_t t6 = t5 & ~x[3];
+    word_t t7 = t4 | t6;
+    word_t t8 = x[0] & ~t5;
+    word_t t9 = x[2] ^ x[3];
+    word_t t10 = t9 & ~x[0];
+    word_t t11 = t8 | t10;
+    word_t t12 = t11 & ~x[4];
+    out[3] = t7 ^ t12;
+    word_t t13 = x[0] ^ t0;
+    word_t t14 = x[3] ^ t5;
+    word_t t15 = t0 & ~x[2];
+    word_t t16 = t15 & x[0];
+    word_t t17 = t14 ^ t16;
+    word_t t18 = t17 & x[3];
+    word_t t19 = t13 ^ t18;
+    word_t t20 = t17 & ~x[5];
+    word_t t21 = t20 ^ x[2];
+    word_t t22 = t9 & x[0];
+    word_t t23 = t21 | t22;
+    word_t t24 = t23 & ~x[4];
+    word_t t25 = t19 ^ t24;
+    word_t t26 = x[4] ^ t14;
+    word_t t27 = x[3] | t25;
+    word_t t28 = t27 ^ t6;
+    word_t t29 = t28 & ~x[0];
+    word_t t30 = t26 ^ t29;
+    word_t t31 = ~x[5];
+    word_t t32 = t11 & x[2];
+    word_t t33 = t10 ^ t32;
+    word_t t34 = t33 & x[4];
+    word_t t35 = t31 & ~t34;
+    word_t t36 = t28 & x[1];
+    word_t t37 = t35 & ~t36;
+    word_t t38 = t30 ^ t37;
+    word_t t39 = t11 & ~t35;
+    word_t t40 = t13 ^ t22;
+    word_t t41 = t10 & ~x[3];
+    word_t t42 = t40 | t41;
+    word_t t43 = t42 & ~x[1];
+    word_t t44 = t39 ^ t43;
+    word_t t45 = t38 & ~t9;
+    word_t t46 = x[5] & ~x[3];
+    word_t t47 = t45 | t46;
+    word_t t48 = x[3] ^ t38;
+    word_t t49 = t48 & x[1];
+    word_t t50 = t47 | t49;
+    word_t t51 = t50 & ~x[4];
+    out[2] = t44 ^ t51;
+    out[0] = t38;
+    out[1] = t25;
+}
+
+/* S4, 44 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox4_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[0] ^ x[2];
+    word_t t1 = x[0] & x[2];
+    word_t t2 = x[3] ^ t1;
+    word_t t3 = t2 & ~x[4];
+    word_t t4 = t0 ^ t3;
+    word_t t5 = x[1] ^ x[3];
+    word_t t6 = t5 & x[4];
+    word_t t7 = x[2] ^ t6;
+    word_t t8 = t5 & x[0];
+    word_t t9 = t7 | t8;
+    word_t t10 = t9 & x[1];
+    word_t t11 = t4 ^ t10;
+    word_t t12 = x[3] | t0;
+    word_t t13 = x[4] & ~x[2];
+    word_t t14 = t12 & ~t13;
+    word_t t15 = x[2] | x[3];
+    word_t t16 = ~t2;
+    word_t t17 = t16 & ~x[4];
+    word_t t18 = t15 ^ t17;
+    word_t t19 = t18 & ~x[1];
+    word_t t20 = t14 ^ t19;
+    word_t t21 = t20 & ~x[5];
+    out[2] = t11 ^ t21;
+    word_t t22 = ~t11;
+    word_t t23 = x[5] & ~t20;
+    out[3] = t22 ^ t23;
+    word_t t24 = t8 ^ t22;
+    word_t t25 = t16 & x[4];
+    word_t t26 = t24 ^ t25;
+    word_t t27 = t20 & ~x[0];
+    word_t t28 = t22 | t27;
+    word_t t29 = t28 & x[2];
+    word_t t30 = t26 ^ t29;
+    word_t t31 = t20 ^ t24;
+    word_t t32 = t9 & x[3];
+    word_t t33 = t31 ^ t32;
+    word_t t34 = x[3] ^ t6;
+    word_t t35 = t34 & ~x[2];
+    word_t t36 = t33 ^ t35;
+    word_t t37 = t36 & ~x[5];
+    out[1] = t30 ^ t37;
+    word_t t38 = ~t30;
+    word_t t39 = x[5] & ~t36;
+    out[0] = t38 ^ t39;
+}
+
+/* S5, 59 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox5_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[1] ^ x[5];
+    word_t t1 = x[2] & ~x[4];
+    word_t t2 = t0 ^ t1;
+    word_t t3 = x[3] & ~x[4];
+    word_t t4 = x[2] | t3;
+    word_t t5 = t4 & ~x[0];
+    word_t t6 = t2 ^ t5;
+    word_t t7 = x[0] ^ x[4];
+    word_t t8 = t7 ^ t1;
+    word_t t9 = t8 ^ x[1];
+    word_t t10 = t5 & ~t2;
+    word_t t11 = t10 & x[5];
+    word_t t12 = t9 ^ t11;
+    word_t t13 = x[2] ^ x[5];
+    word_t t14 = t13 & x[0];
+    word_t t15 = t12 | t14;
+    word_t t16 = t15 & ~x[3];
+    out[1] = t6 ^ t16;
+    word_t t17 = t15 & ~x[5];
+    word_t t18 = t7 ^ t17;
+    word_t t19 = x[2] ^ t12;
+    word_t t20 = t19 | x[0];
+    word_t t21 = t20 & x[3];
+    word_t t22 = t18 ^ t21;
+    word_t t23 = x[5] | t19;
+    word_t t24 = x[3] & ~t2;
+    word_t t25 = t24 & x[0];
+    word_t t26 = t23 ^ t25;
+    word_t t27 = x[4] & ~t13;
+    word_t t28 = t27 & ~x[3];
+    word_t t29 = t26 & ~t28;
+    word_t t30 = t29 & x[1];
+    out[3] = t22 ^ t30;
+    word_t t31 = t8 | t11;
+    word_t t32 = t31 & ~t25;
+    word_t t33 = t13 ^ t26;
+    word_t t34 = t0 & ~x[2];
+    word_t t35 = t33 & ~t34;
+    word_t t36 = t35 & x[4];
+    word_t t37 = t32 ^ t36;
+    word_t t38 = t5 ^ t19;
+    word_t t39 = t38 ^ x[5];
+    word_t t40 = x[4] & x[1];
+    word_t t41 = t39 | t40;
+    word_t t42 = t41 & ~x[3];
+    out[0] = t37 ^ t42;
+    word_t t43 = x[0] | t35;
+    word_t t44 = x[4] ^ t4;
+    word_t t45 = t44 & x[3];
+    word_t t46 = t43 ^ t45;
+    word_t t47 = t46 & ~t28;
+    word_t t48 = x[0] | x[5];
+    word_t t49 = ~t42;
+    word_t t50 = x[2] & x[0];
+    word_t t51 = t49 ^ t50;
+    word_t t52 = t51 & ~x[4];
+    word_t t53 = t48 ^ t52;
+    word_t t54 = t53 & ~x[1];
+    out[2] = t47 ^ t54;
+}
+
+/* S6, 55 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox6_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[3] ^ x[4];
+    word_t t1 = t0 ^ x[2];
+    word_t t2 = t1 ^ x[0];
+    word_t t3 = x[2] & ~x[0];
+    word_t t4 = t3 & x[4];
+    word_t t5 = t2 | t4;
+    word_t t6 = t2 & x[0];
+    word_t t7 = t0 ^ t6;
+    word_t t8 = t7 & x[3];
+    word_t t9 = x[1] & ~t8;
+    word_t t10 = t5 ^ t9;
+    word_t t11 = x[3] ^ t9;
+    word_t t12 = x[4] | t2;
+    word_t t13 = t12 & ~x[1];
+    word_t t14 = t11 ^ t13;
+    word_t t15 = ~x[1];
+    word_t t16 = t15 & ~x[0];
+    word_t t17 = t14 | t16;
+    word_t t18 = t17 & ~x[5];
+    word_t t19 = t10 ^ t18;
+    word_t t20 = x[4] ^ t12;
+    word_t t21 = t20 ^ t15;
+    word_t t22 = t21 & ~x[2];
+    word_t t23 = t2 ^ t22;
+    word_t t24 = x[0] | x[2];
+    word_t t25 = t24 & ~x[1];
+    word_t t26 = t12 | t25;
+    word_t t27 = t23 & ~t17;
+    word_t t28 = t26 & ~t27;
+    word_t t29 = t28 & x[5];
+    word_t t30 = t23 ^ t29;
+    word_t t31 = t2 ^ t25;
+    word_t t32 = t17 & ~t24;
+    word_t t33 = t19 & x[2];
+    word_t t34 = t32 | t33;
+    word_t t35 = t34 & x[4];
+    word_t t36 = t31 ^ t35;
+    word_t t37 = t13 & ~t2;
+    word_t t38 = x[2] & ~t37;
+    word_t t39 = t10 | t30;
+    word_t t40 = t39 ^ t6;
+    word_t t41 = t40 & ~x[2];
+    word_t t42 = t38 | t41;
+    word_t t43 = t42 & x[5];
+    out[2] = t36 ^ t43;
+    word_t t44 = t3 ^ t21;
+    word_t t45 = t20 ^ t36;
+    word_t t46 = t45 | x[0];
+    word_t t47 = t46 & x[5];
+    word_t t48 = t44 ^ t47;
+    word_t t49 = x[2] & ~x[4];
+    word_t t50 = t23 ^ t49;
+    word_t t51 = t50 | t47;
+    word_t t52 = t51 & ~x[3];
+    out[3] = t48 ^ t52;
+    out[0] = t30;
+    out[1] = t19;
+}
+
+/* S7, 55 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox7_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[4] ^ x[5];
+    word_t t1 = t0 ^ x[2];
+    word_t t2 = t1 ^ x[0];
+    word_t t3 = t2 ^ x[3];
+    word_t t4 = t3 & x[0];
+    word_t t5 = x[1] ^ t4;
+    word_t t6 = t5 & x[5];
+    word_t t7 = t1 ^ t6;
+    word_t t8 = t7 & x[1];
+    word_t t9 = t3 ^ t8;
+    word_t t10 = t7 & x[3];
+    word_t t11 = x[1] ^ t10;
+    word_t t12 = x[3] & ~x[5];
+    word_t t13 = t11 ^ t12;
+    word_t t14 = t13 & ~x[4];
+    out[3] = t9 ^ t14;
+    word_t t15 = ~t3;
+    word_t t16 = t15 ^ x[4];
+    word_t t17 = t16 & ~x[1];
+    word_t t18 = t1 ^ t17;
+    word_t t19 = t13 & x[2];
+    word_t t20 = t16 | t19;
+    word_t t21 = t20 & x[0];
+    word_t t22 = t18 ^ t21;
+    word_t t23 = t0 & ~x[0];
+    word_t t24 = t10 & ~t23;
+    word_t t25 = t24 & x[5];
+    out[1] = t22 ^ t25;
+    word_t t26 = x[3] & x[1];
+    word_t t27 = t2 ^ t26;
+    word_t t28 = t11 ^ t17;
+    word_t t29 = t28 & ~x[5];
+    word_t t30 = t27 ^ t29;
+    word_t t31 = t5 & x[0];
+    word_t t32 = t30 & ~t31;
+    word_t t33 = t31 & x[3];
+    word_t t34 = t29 ^ t33;
+    word_t t35 = t4 | t31;
+    word_t t36 = t35 & x[5];
+    word_t t37 = t34 | t36;
+    word_t t38 = t37 & ~x[2];
+    word_t t39 = t32 ^ t38;
+    word_t t40 = t14 ^ t18;
+    word_t t41 = t40 ^ t35;
+    word_t t42 = x[1] ^ t40;
+    word_t t43 = t42 | x[0];
+    word_t t44 = t43 & ~x[3];
+    word_t t45 = t41 ^ t44;
+    word_t t46 = x[0] & ~x[1];
+    word_t t47 = t19 | t46;
+    word_t t48 = x[0] ^ t39;
+    word_t t49 = t48 & ~x[3];
+    word_t t50 = t47 ^ t49;
+    word_t t51 = t50 & ~x[5];
+    out[2] = t45 ^ t51;
+    out[0] = t39;
+}
+
+/* S8, 50 gates. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox8_bitslice(const word_t x[6], word_t out[4]) {
+    word_t t0 = x[1] ^ x[3];
+    word_t t1 = x[2] & ~x[4];
+    word_t t2 = t0 ^ t1;
+    word_t t3 = x[1] | x[2];
+    word_t t4 = t3 ^ x[4];
+    word_t t5 = x[1] & ~x[3];
+    word_t t6 = t4 & ~t5;
+    word_t t7 = t6 & ~x[0];
+    word_t t8 = t2 ^ t7;
+    word_t t9 = ~x[5];
+    word_t t10 = x[4] & ~x[2];
+    word_t t11 = t0 ^ t3;
+    word_t t12 = t11 & x[3];
+    word_t t13 = t10 ^ t12;
+    word_t t14 = t13 & x[0];
+    word_t t15 = t9 & ~t14;
+    out[1] = t8 ^ t15;
+    word_t t16 = t3 ^ t8;
+    word_t t17 = x[0] ^ t10;
+    word_t t18 = t16 & ~x[4];
+    word_t t19 = t17 & x[4];
+    word_t t20 = t18 | t19;
+    word_t t21 = t20 ^ t5;
+    word_t t22 = x[0] ^ t4;
+    word_t t23 = t13 & x[1];
+    word_t t24 = t22 & ~t23;
+    word_t t25 = ~t7;
+    word_t t26 = t25 & ~x[3];
+    word_t t27 = t24 ^ t26;
+    word_t t28 = t27 & ~x[5];
+    out[0] = t21 ^ t28;
+    word_t t29 = t16 ^ t22;
+    word_t t30 = t18 & ~x[0];
+    word_t t31 = t10 ^ t30;
+    word_t t32 = t31 & ~x[1];
+    word_t t33 = t29 ^ t32;
+    word_t t34 = t21 | t32;
+    word_t t35 = t2 & x[1];
+    word_t t36 = t34 | t35;
+    word_t t37 = t20 & ~x[0];
+    word_t t38 = t36 & ~t37;
+    word_t t39 = t38 & x[5];
+    out[2] = t33 ^ t39;
+    word_t t40 = t9 & ~t21;
+    word_t t41 = t16 & x[3];
+    word_t t42 = t29 ^ t41;
+    word_t t43 = t42 & x[5];
+    word_t t44 = t40 | t43;
+    word_t t45 = x[5] & ~x[2];
+    out[3] = t44 ^ t45;
+}
+
+/* Evaluate S-box number `box` (0 to 7) on the input planes x into out. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void sbox_bitslice(const uint8_t box, const word_t x[6], word_t out[4]) {
+    switch (box) {
+        case 0:
+            sbox1_bitslice(x, out);
+            break;
+        case 1:
+            sbox2_bitslice(x, out);
+            break;
+        case 2:
+            sbox3_bitslice(x, out);
+            break;
+        case 3:
+            sbox4_bitslice(x, out);
+            break;
+        case 4:
+            sbox5_bitslice(x, out);
+            break;
+        case 5:
+            sbox6_bitslice(x, out);
+            break;
+        case 6:
+            sbox7_bitslice(x, out);
+            break;
+        default:
+            sbox8_bitslice(x, out);
+            break;
+    }
+}
+
+/* Run IP, the 16 rounds and IP-1 on bit-planes in place. subkeys[i][j] is the plane of bit
+ * j + 1 of the subkey used in round i + 1 (all ones or all zeros when every lane shares a key). */
+template<typename word_t>
+static DES_BITSLICE_INLINE void des_bitslice_core(word_t planes[64], const word_t subkeys[DES_ROUNDS][48], bool decrypt) {
+    word_t halves[2][32], expanded[6], sbox_output[32];
+    word_t* l = halves[0];
+    word_t* r = halves[1];
+
+    for (uint8_t i = 0; i < 32; i++) {
+        l[i] = planes[IP[i] - 1];
+        r[i] = planes[IP[32 + i] - 1];
+    }
+
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        const word_t* k = subkeys[decrypt ? (DES_ROUNDS - 1 - i) : i];
+
+        for (uint8_t box = 0; box < 8; box++) {
+            for (uint8_t j = 0; j < 6; j++) {
+                expanded[j] = r[E[(6 * box) + j] - 1] ^ k[(6 * box) + j];
+            }
+            sbox_bitslice(box, expanded, &sbox_output[4 * box]);
+        }
+
+        /* L ^= P(S(...)); the halves then swap roles. */
+        for (uint8_t j = 0; j < 32; j++) {
+            l[j] = l[j] ^ sbox_output[P[j] - 1];
+        }
+
+        word_t* t = l;
+        l = r;
+        r = t;
+    }
+
+    /* The pre-output block is R16 L16. */
+    for (uint8_t i = 0; i < 64; i++) {
+        uint8_t bit = IP_INV[i] - 1;
+        planes[i] = (bit < 32) ? r[bit] : l[bit - 32];
+    }
+}
+
+/* Transpose 64 * lanes words (the first n of src, zero past them) into 64 planes of word_t,
+ * and back. Each 64-bit lane of the planes holds 64 consecutive words. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void bitslice_load(const uint64_t* src, size_t n, word_t planes[64]) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    uint64_t staging[lanes][64], lane_words[lanes];
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        for (size_t j = 0; j < DES_BITSLICE_BLOCKS; j++) {
+            size_t block = (lane * DES_BITSLICE_BLOCKS) + j;
+            staging[lane][j] = (block < n) ? src[block] : 0;
+        }
+        transpose_64x64(staging[lane]);
+    }
+    for (uint8_t i = 0; i < 64; i++) {
+        for (size_t lane = 0; lane < lanes; lane++) {
+            lane_words[lane] = staging[lane][i];
+        }
+        memcpy(&planes[i], lane_words, sizeof(word_t));
+    }
+}
+
+template<typename word_t>
+static DES_BITSLICE_INLINE void bitslice_store(const word_t planes[64], size_t n, uint64_t* dst) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    uint64_t staging[lanes][64], lane_words[lanes];
+
+    for (uint8_t i = 0; i < 64; i++) {
+        memcpy(lane_words, &planes[i], sizeof(word_t));
+        for (size_t lane = 0; lane < lanes; lane++) {
+            staging[lane][i] = lane_words[lane];
+        }
+    }
+    for (size_t lane = 0; lane < lanes; lane++) {
+        transpose_64x64(staging[lane]);
+        for (size_t j = 0; j < DES_BITSLICE_BLOCKS; j++) {
+            size_t block = (lane * DES_BITSLICE_BLOCKS) + j;
+            if (block < n) {
+                dst[block] = staging[lane][j];
+            }
+        }
+    }
+}
+
+/* Encrypt or decrypt `count` blocks with planes of word_t, i.e. 64 blocks per 64-bit lane of
+ * the word. A short final batch is padded with zero blocks. Everything down to the S-box
+ * circuits is inlined so each kernel below is compiled for its own instruction set. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void des_bitslice_process(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    const size_t batch = DES_BITSLICE_BLOCKS * lanes;
+    uint64_t lane_words[lanes];
+    word_t planes[64], subkeys[DES_ROUNDS][48];
+
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        for (uint8_t j = 0; j < 48; j++) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                lane_words[lane] = 0 - ((key_context.round_keys[i] >> (47 - j)) & 1);
+            }
+            memcpy(&subkeys[i][j], lane_words, sizeof(word_t));
+        }
+    }
+
+    for (size_t done = 0; done < count; done += batch) {
+        size_t n = (count - done < batch) ? (count - done) : batch;
+
+        bitslice_load(input + done, n, planes);
+        des_bitslice_core(planes, subkeys, decrypt);
+        bitslice_store(planes, n, output + done);
+    }
+}
+
+/* Like des_bitslice_process, but block i is run under keys[i]. The keys are transposed into
+ * planes like the blocks, and the key schedule is only wiring from key planes to subkey
+ * planes, so no key is ever expanded on its own. */
+template<typename word_t>
+static DES_BITSLICE_INLINE void des_bitslice_keyed_process(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    const size_t batch = DES_BITSLICE_BLOCKS * lanes;
+    word_t planes[64], key_planes[64], subkeys[DES_ROUNDS][48];
+
+    for (size_t done = 0; done < count; done += batch) {
+        size_t n = (count - done < batch) ? (count - done) : batch;
+
+        bitslice_load(keys + done, n, key_planes);
+        for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+            for (uint8_t j = 0; j < 48; j++) {
+                subkeys[i][j] = key_planes[KEY_SCHEDULE_BITS.bit[i][j] - 1];
+            }
+        }
+
+        bitslice_load(input + done, n, planes);
+        des_bitslice_core(planes, subkeys, decrypt);
+        bitslice_store(planes, n, output + done);
+    }
+}
+
+template<typename word_t>
+static DES_BITSLICE_INLINE void bitslice_broadcast(word_t& word, const uint64_t value) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    uint64_t lane_words[lanes];
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        lane_words[lane] = value;
+    }
+    memcpy(&word, lane_words, sizeof(word_t));
+}
+
+template<typename word_t>
+static DES_BITSLICE_INLINE bool bitslice_all_ones(const word_t& word) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    uint64_t lane_words[lanes], all = ~0ULL;
+
+    memcpy(lane_words, &word, sizeof(word_t));
+    for (size_t lane = 0; lane < lanes; lane++) {
+        all &= lane_words[lane];
+    }
+    return all == ~0ULL;
+}
+
+/* Key search over 64 * lanes keys per pass. Key index bits 0..5 vary inside a 64-bit lane and
+ * the next log2(lanes) bits across lanes, so the passes walk the index space in order. */
+template<typename word_t>
+static DES_BITSLICE_INLINE size_t des_bitslice_search_process(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next) {
+    const size_t lanes = sizeof(word_t) / sizeof(uint64_t);
+    const uint64_t batch = DES_BITSLICE_BLOCKS * lanes;
+    const uint64_t lane_patterns[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+    };
+    uint64_t lane_words[lanes], miss_words[2][lanes];
+    word_t l0[32], r0[32], targets[2][32], key_planes[64];
+    word_t halves[2][32], expanded[6], sbox_output[4];
+    int8_t searched[64];
+    uint64_t end = first + count, ip_plaintext = permute_bytes(search.plaintext, IP_BYTES);
+    size_t found = 0;
+
+    /* IP(plaintext) is shared by every lane; of each target only L16 (the low half of the
+     * pre-output block IP(c)) is needed, since L16 = R15. */
+    for (uint8_t i = 0; i < 32; i++) {
+        bitslice_broadcast(l0[i], 0 - ((ip_plaintext >> (63 - i)) & 1));
+        bitslice_broadcast(r0[i], 0 - ((ip_plaintext >> (31 - i)) & 1));
+    }
+    for (uint8_t t = 0; t < 2; t++) {
+        uint64_t ip_target = permute_bytes(search.targets[(t < search.target_count) ? t : 0], IP_BYTES);
+        for (uint8_t j = 0; j < 32; j++) {
+            bitslice_broadcast(targets[t][j], 0 - ((ip_target >> (31 - j)) & 1));
+        }
+    }
+
+    /* key_planes[d] is the plane of key bit d + 1; the bits that are not searched never change. */
+    for (uint8_t d = 0; d < 64; d++) {
+        searched[d] = -1;
+        bitslice_broadcast(key_planes[d], 0 - ((search.base_key >> (63 - d)) & 1));
+    }
+    for (uint8_t s = 0; s < search.bit_count; s++) {
+        uint8_t d = 63 - search.bits[s];
+        searched[d] = s;
+        if (s < 6) {
+            bitslice_broadcast(key_planes[d], lane_patterns[s]);
+        }
+        else if ((1ULL << (s - 6)) < lanes) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                lane_words[lane] = 0 - static_cast<uint64_t>((lane >> (s - 6)) & 1);
+            }
+            memcpy(&key_planes[d], lane_words, sizeof(word_t));
+        }
+    }
+
+    for (uint64_t base = first - (first % batch); base < end; base += batch) {
+        word_t* l = halves[0];
+        word_t* r = halves[1];
+        word_t miss[2];
+        bool alive = true;
+
+        for (uint8_t d = 0; d < 64; d++) {
+            if (searched[d] >= 0 && (1ULL << searched[d]) >= batch) {
+                bitslice_broadcast(key_planes[d], 0 - ((base >> searched[d]) & 1));
+            }
+        }
+
+        for (uint8_t i = 0; i < 32; i++) {
+            l[i] = l0[i];
+            r[i] = r0[i];
+        }
+
+        /* Rounds 1 to 14 in full. */
+        for (uint8_t i = 0; i < DES_ROUNDS - 2; i++) {
+            word_t f[32];
+
+            for (uint8_t box = 0; box < 8; box++) {
+                for (uint8_t j = 0; j < 6; j++) {
+                    expanded[j] = r[E[(6 * box) + j] - 1] ^ key_planes[KEY_SCHEDULE_BITS.bit[i][(6 * box) + j] - 1];
+                }
+                sbox_bitslice(box, expanded, &f[4 * box]);
+            }
+            for (uint8_t j = 0; j < 32; j++) {
+                l[j] = l[j] ^ f[P[j] - 1];
+            }
+
+            word_t* t = l;
+            l = r;
+            r = t;
+        }
+
+        /* Round 15 one S-box at a time: R15 = L14 ^ f(R14, K15) must equal a target's L16, and
+         * the pass stops as soon as no lane can match any more. */
+        bitslice_broadcast(miss[0], 0);
+        bitslice_broadcast(miss[1], (search.target_count > 1) ? 0 : ~0ULL);
+        for (uint8_t box = 0; box < 8 && alive; box++) {
+            for (uint8_t j = 0; j < 6; j++) {
+                expanded[j] = r[E[(6 * box) + j] - 1] ^ key_planes[KEY_SCHEDULE_BITS.bit[DES_ROUNDS - 2][(6 * box) + j] - 1];
+            }
+            sbox_bitslice(box, expanded, sbox_output);
+
+            for (uint8_t q = 0; q < 4; q++) {
+                uint8_t j = sbox_wiring.p_inverse[(4 * box) + q];
+                word_t bit = l[j] ^ sbox_output[q];
+                miss[0] |= bit ^ targets[0][j];
+                miss[1] |= bit ^ targets[1][j];
+            }
+            word_t both = miss[0] & miss[1];
+            alive = !bitslice_all_ones(both);
+        }
+        if (!alive) {
+            continue;
+        }
+
+        /* Lanes and bits in order walk the indices in order; the candidates of one key are
+         * written together, so a full buffer stops at a key boundary and no key is lost. */
+        memcpy(miss_words[0], &miss[0], sizeof(word_t));
+        memcpy(miss_words[1], &miss[1], sizeof(word_t));
+        for (size_t lane = 0; lane < lanes; lane++) {
+            for (uint64_t hits = ~(miss_words[0][lane] & miss_words[1][lane]); hits != 0; hits &= hits - 1) {
+                uint8_t bit = static_cast<uint8_t>(__builtin_ctzll(hits));
+                uint64_t index = base + (lane * DES_BITSLICE_BLOCKS) + bit;
+                uint8_t matches = static_cast<uint8_t>(((~miss_words[0][lane] >> bit) & 1) + ((~miss_words[1][lane] >> bit) & 1));
+
+                if (index < first || index >= end) {
+                    continue;
+                }
+                if (found + matches > capacity) {
+                    next = index;
+                    return found;
+                }
+                for (uint8_t t = 0; t < 2; t++) {
+                    if ((~miss_words[t][lane] >> bit) & 1) {
+                        candidates[found].index = index;
+                        candidates[found].target = t;
+                        found++;
+                    }
+                }
+            }
+        }
+    }
+    next = end;
+    return found;
+}
+
+static void des_bitslice_kernel_scalar(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    des_bitslice_process<uint64_t>(input, output, count, key_context, decrypt);
+}
+
+#ifdef DES_BITSLICE_X86
+__attribute__((target("avx2")))
+static void des_bitslice_kernel_avx2(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    des_bitslice_process<avx2_word_t>(input, output, count, key_context, decrypt);
+}
+
+__attribute__((target("avx512f")))
+static void des_bitslice_kernel_avx512(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    des_bitslice_process<avx512_word_t>(input, output, count, key_context, decrypt);
+}
+#endif
+
+static void des_bitslice_keyed_scalar(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt) {
+    des_bitslice_keyed_process<uint64_t>(keys, input, output, count, decrypt);
+}
+
+#ifdef DES_BITSLICE_X86
+__attribute__((target("avx2")))
+static void des_bitslice_keyed_avx2(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt) {
+    des_bitslice_keyed_process<avx2_word_t>(keys, input, output, count, decrypt);
+}
+
+__attribute__((target("avx512f")))
+static void des_bitslice_keyed_avx512(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt) {
+    des_bitslice_keyed_process<avx512_word_t>(keys, input, output, count, decrypt);
+}
+#endif
+
+static size_t des_bitslice_search_scalar(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next) {
+    return des_bitslice_search_process<uint64_t>(search, first, count, candidates, capacity, next);
+}
+
+#ifdef DES_BITSLICE_X86
+__attribute__((target("avx2")))
+static size_t des_bitslice_search_avx2(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next) {
+    return des_bitslice_search_process<avx2_word_t>(search, first, count, candidates, capacity, next);
+}
+
+__attribute__((target("avx512f")))
+static size_t des_bitslice_search_avx512(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next) {
+    return des_bitslice_search_process<avx512_word_t>(search, first, count, candidates, capacity, next);
+}
+#endif
+
+static bool des_bitslice_kernel_supported(des_bitslice_kernel_t kernel) {
+    switch (kernel) {
+        case DES_BITSLICE_KERNEL_SCALAR:
+            return true;
+#ifdef DES_BITSLICE_X86
+        case DES_BITSLICE_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case DES_BITSLICE_KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+static des_bitslice_kernel_t des_bitslice_kernel_detect() {
+    if (des_bitslice_kernel_supported(DES_BITSLICE_KERNEL_AVX512)) {
+        return DES_BITSLICE_KERNEL_AVX512;
+    }
+    if (des_bitslice_kernel_supported(DES_BITSLICE_KERNEL_AVX2)) {
+        return DES_BITSLICE_KERNEL_AVX2;
+    }
+    return DES_BITSLICE_KERNEL_SCALAR;
+}
+
+static void des_bitslice_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    des_bitslice_kernel_t kernel = active_kernel.load(memory_order_relaxed);
+    size_t done = 0;
+
+    /* Whole batches go to the widest selected kernel; what is left drops to narrower ones so
+     * a short tail does not pay for a full 512-block pass. */
+#ifdef DES_BITSLICE_X86
+    if (kernel == DES_BITSLICE_KERNEL_AVX512) {
+        size_t n = (count / (8 * DES_BITSLICE_BLOCKS)) * (8 * DES_BITSLICE_BLOCKS);
+        des_bitslice_kernel_avx512(input, output, n, key_context, decrypt);
+        done = n;
+    }
+    if (kernel >= DES_BITSLICE_KERNEL_AVX2 && des_bitslice_kernel_supported(DES_BITSLICE_KERNEL_AVX2)) {
+        size_t n = ((count - done) / (4 * DES_BITSLICE_BLOCKS)) * (4 * DES_BITSLICE_BLOCKS);
+        des_bitslice_kernel_avx2(input + done, output + done, n, key_context, decrypt);
+        done += n;
+    }
+#endif
+    des_bitslice_kernel_scalar(input + done, output + done, count - done, key_context, decrypt);
+}
+
+static void des_bitslice_process_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count, bool decrypt) {
+    des_bitslice_kernel_t kernel = active_kernel.load(memory_order_relaxed);
+    size_t done = 0;
+
+#ifdef DES_BITSLICE_X86
+    if (kernel == DES_BITSLICE_KERNEL_AVX512) {
+        size_t n = (count / (8 * DES_BITSLICE_BLOCKS)) * (8 * DES_BITSLICE_BLOCKS);
+        des_bitslice_keyed_avx512(keys, input, output, n, decrypt);
+        done = n;
+    }
+    if (kernel >= DES_BITSLICE_KERNEL_AVX2 && des_bitslice_kernel_supported(DES_BITSLICE_KERNEL_AVX2)) {
+        size_t n = ((count - done) / (4 * DES_BITSLICE_BLOCKS)) * (4 * DES_BITSLICE_BLOCKS);
+        des_bitslice_keyed_avx2(keys + done, input + done, output + done, n, decrypt);
+        done += n;
+    }
+#endif
+    des_bitslice_keyed_scalar(keys + done, input + done, output + done, count - done, decrypt);
+}
+
+/* Function Definitions -----------------------------------------------------*/
+void transpose_64x64(uint64_t planes[64]) {
+    /* Swap ever smaller off-diagonal sub-blocks: bit (63 - c) of word r moves to bit (63 - r)
+     * of word c, so with blocks as words, word i becomes the plane of DES bit i + 1. */
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+
+    for (uint8_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (uint8_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = (planes[k] ^ (planes[k | j] >> j)) & mask;
+            planes[k] ^= t;
+            planes[k | j] ^= t << j;
+        }
+    }
+}
+
+bool des_bitslice_set_kernel(des_bitslice_kernel_t kernel) {
+    if (kernel == DES_BITSLICE_KERNEL_AUTO) {
+        kernel = des_bitslice_kernel_detect();
+    }
+    if (!des_bitslice_kernel_supported(kernel)) {
+        return false;
+    }
+    active_kernel.store(kernel, memory_order_relaxed);
+    return true;
+}
+
+des_bitslice_kernel_t des_bitslice_get_kernel() {
+    return active_kernel.load(memory_order_relaxed);
+}
+
+const char* des_bitslice_kernel_name(des_bitslice_kernel_t kernel) {
+    switch (kernel) {
+        case DES_BITSLICE_KERNEL_SCALAR:
+            return "scalar";
+        case DES_BITSLICE_KERNEL_AVX2:
+            return "avx2";
+        case DES_BITSLICE_KERNEL_AVX512:
+            return "avx512";
+        default:
+            return "auto";
+    }
+}
+
+void des_bitslice_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context) {
+    des_bitslice_process_blocks(input, output, count, key_context, false);
+}
+
+void des_bitslice_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context) {
+    des_bitslice_process_blocks(input, output, count, key_context, true);
+}
+
+void des_bitslice_encrypt_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count) {
+    des_bitslice_process_keyed_blocks(keys, input, output, count, false);
+}
+
+void des_bitslice_decrypt_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count) {
+    des_bitslice_process_keyed_blocks(keys, input, output, count, true);
+}
+
+size_t des_bitslice_search_keys(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next) {
+    switch (active_kernel.load(memory_order_relaxed)) {
+#ifdef DES_BITSLICE_X86
+        case DES_BITSLICE_KERNEL_AVX512:
+            return des_bitslice_search_avx512(search, first, count, candidates, capacity, next);
+        case DES_BITSLICE_KERNEL_AVX2:
+            return des_bitslice_search_avx2(search, first, count, candidates, capacity, next);
+#endif
+        default:
+            return des_bitslice_search_scalar(search, first, count, candidates, capacity, next);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * \file       des_bitslice.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the bitsliced des engine
+ * \details    64 blocks are transposed into 64 bit-planes (plane i holds bit i + 1 of every
+ *             block), so IP, IP-1, E and P become plain wiring and the S-boxes are evaluated
+ *             as boolean gate networks on whole planes. The engine has no secret-dependent
+ *             memory accesses or branches.
+ ******************************************************************************
+*/
+#ifndef DES_BITSLICE_H
+#define	DES_BITSLICE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_fast.h"
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_BITSLICE_BLOCKS     64
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* Kernels in increasing width: 64, 256 (AVX2) and 512 (AVX-512) blocks per pass. */
+typedef enum {
+    DES_BITSLICE_KERNEL_AUTO,
+    DES_BITSLICE_KERNEL_SCALAR,
+    DES_BITSLICE_KERNEL_AVX2,
+    DES_BITSLICE_KERNEL_AVX512
+} des_bitslice_kernel_t;
+
+/* A known-plaintext key search. Key index n stands for base_key with key bit bits[s] (0 is
+ * the least significant bit of the 64-bit key) set to bit s of n, for s < bit_count. A key
+ * matches when it encrypts plaintext to one of the target_count targets. */
+typedef struct {
+    uint64_t plaintext;
+    uint64_t targets[2];
+    uint8_t target_count;
+    uint64_t base_key;
+    uint8_t bits[56];
+    uint8_t bit_count;
+} des_bitslice_search_t;
+
+typedef struct {
+    uint64_t index;
+    uint8_t target;
+} des_bitslice_candidate_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+void transpose_64x64(uint64_t planes[64]);
+
+/* The widest kernel the CPU supports is picked at startup; set_kernel overrides it and fails
+ * when the CPU lacks the instruction set. */
+bool des_bitslice_set_kernel(des_bitslice_kernel_t kernel);
+des_bitslice_kernel_t des_bitslice_get_kernel();
+const char* des_bitslice_kernel_name(des_bitslice_kernel_t kernel);
+
+void des_bitslice_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context);
+void des_bitslice_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context);
+
+/* Block i under its own key keys[i] (raw 64-bit DES keys): many keys with few blocks each
+ * without running a key setup per key. */
+void des_bitslice_encrypt_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count);
+void des_bitslice_decrypt_keyed_blocks(const uint64_t* keys, const uint64_t* input, uint64_t* output, size_t count);
+
+/* Try key indices [first, first + count) with one key per lane and the key schedule as wiring.
+ * Keys are dropped as soon as their R15 cannot match, so only round 15 is checked and round 16
+ * never runs: the survivors are candidates that still need a full encryption to confirm.
+ * Candidates come in index order; returns how many were written (at most capacity, which
+ * must be at least 2). next is first + count when the range is done, or else the index to
+ * call again from because the buffer filled up. */
+size_t des_bitslice_search_keys(const des_bitslice_search_t& search, uint64_t first, uint64_t count, des_bitslice_candidate_t* candidates, size_t capacity, uint64_t& next);
+
+#endif	/* DES_BITSLICE_H */
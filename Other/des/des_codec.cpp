@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ * \file       des_codec.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the block text codecs
+ ******************************************************************************
+*/
+#include "des_codec.h"
+#include <cstring>
+
+/* Macro Declarations -------------------------------------------------------*/
+#define SWAR_ONES   0x0101010101010101ULL
+#define SWAR_HIGH   0x8080808080808080ULL
+
+/* Static Functions Declarations --------------------------------------------*/
+static inline uint64_t load_chars(const char* text);
+static inline void store_chars(char* text, uint64_t word);
+static inline uint64_t bytes_in_range(const uint64_t word, const uint8_t low, const uint8_t high);
+static inline uint64_t bytes_at_least(const uint64_t word, const uint8_t low);
+static inline bool hex_decode_word(const uint64_t word, uint32_t& value);
+static inline uint64_t hex_encode_word(const uint32_t value);
+static inline bool base64_decode_word(const uint64_t word, uint64_t& sextets);
+static inline uint64_t base64_encode_word(const uint64_t sextets);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_codec_from_string(const string& name, des_codec_t& codec) {
+    if (name == "hex") {
+        codec = DES_CODEC_HEX;
+    }
+    else if (name == "base64") {
+        codec = DES_CODEC_BASE64;
+    }
+    else if (name == "raw") {
+        codec = DES_CODEC_RAW;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+size_t des_codec_block_chars(const des_codec_t codec) {
+    switch (codec) {
+        case DES_CODEC_HEX:
+            return DES_HEX_BLOCK_CHARS;
+        case DES_CODEC_BASE64:
+            return DES_BASE64_BLOCK_CHARS;
+        default:
+            return sizeof(uint64_t);
+    }
+}
+
+void des_hex_encode_block(const uint64_t block, char* text) {
+    store_chars(text, hex_encode_word(static_cast<uint32_t>(block >> 32)));
+    store_chars(text + 8, hex_encode_word(static_cast<uint32_t>(block)));
+}
+
+bool des_hex_decode_block(const char* text, uint64_t& block) {
+    uint32_t high, low;
+    bool ok = hex_decode_word(load_chars(text), high);
+
+    /* Both halves are always decoded; one branch at the end instead of one per half. */
+    ok = hex_decode_word(load_chars(text + 8), low) && ok;
+    block = (static_cast<uint64_t>(high) << 32) | low;
+    return ok;
+}
+
+void des_base64_encode_block(const uint64_t block, char* text) {
+    uint64_t first = 0, last = 0;
+
+    /* 64 bits are ten full sextets plus four bits, shifted up to make the eleventh. */
+    for (uint8_t i = 0; i < 8; i++) {
+        first |= ((block >> (58 - (6 * i))) & 0x3F) << (8 * i);
+    }
+    last = ((block >> 10) & 0x3F) | (((block >> 4) & 0x3F) << 8) | ((block & 0x0F) << 18);
+
+    store_chars(text, base64_encode_word(first));
+    last = base64_encode_word(last);
+    text[8] = static_cast<char>(last);
+    text[9] = static_cast<char>(last >> 8);
+    text[10] = static_cast<char>(last >> 16);
+    text[11] = '=';
+}
+
+bool des_base64_decode_block(const char* text, uint64_t& block) {
+    uint64_t first, last, tail = load_chars(text + 4);
+    bool ok = base64_decode_word(load_chars(text), first);
+
+    /* Characters 8..10 land in the low bytes; the rest is filled with 'A', which decodes to 0. */
+    tail = (tail >> 32) & 0x0000000000FFFFFFULL;
+    ok = base64_decode_word(tail | (0x4141414141ULL << 24), last) && ok;
+
+    block = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        block |= ((first >> (8 * i)) & 0x3F) << (58 - (6 * i));
+    }
+    block |= ((last & 0x3F) << 10) | (((last >> 8) & 0x3F) << 4) | (((last >> 16) & 0x3F) >> 2);
+    return ok && ((last >> 16) & 0x03) == 0 && text[11] == '=';
+}
+
+void des_codec_encode_block(const des_codec_t codec, const uint64_t block, char* text) {
+    switch (codec) {
+        case DES_CODEC_HEX:
+            des_hex_encode_block(block, text);
+            break;
+        case DES_CODEC_BASE64:
+            des_base64_encode_block(block, text);
+            break;
+        default:
+            for (int8_t i = 7; i >= 0; i--) {
+                text[7 - i] = static_cast<char>(block >> (8 * i));
+            }
+            break;
+    }
+}
+
+bool des_codec_decode_block(const des_codec_t codec, const char* text, uint64_t& block) {
+    switch (codec) {
+        case DES_CODEC_HEX:
+            return des_hex_decode_block(text, block);
+        case DES_CODEC_BASE64:
+            return des_base64_decode_block(text, block);
+        default:
+            block = 0;
+            for (uint8_t i = 0; i < 8; i++) {
+                block = (block << 8) | static_cast<uint8_t>(text[i]);
+            }
+            return true;
+    }
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+/* Eight characters as a word, the first character in the low byte. */
+static inline uint64_t load_chars(const char* text) {
+    uint64_t word;
+    memcpy(&word, text, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static inline void store_chars(char* text, uint64_t word) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    memcpy(text, &word, sizeof(word));
+}
+
+/* 0x80 in every byte of word within [low, high]. The bytes must be below 0x80, so neither sum
+ * carries into the next byte. */
+static inline uint64_t bytes_in_range(const uint64_t word, const uint8_t low, const uint8_t high) {
+    return (word + (SWAR_ONES * (0x80 - low))) & ~(word + (SWAR_ONES * (0x7F - high))) & SWAR_HIGH;
+}
+
+/* 0x01 in every byte of word that is at least low (bytes below 0x80). */
+static inline uint64_t bytes_at_least(const uint64_t word, const uint8_t low) {
+    return ((word + (SWAR_ONES * (0x80 - low))) >> 7) & SWAR_ONES;
+}
+
+static inline bool hex_decode_word(const uint64_t word, uint32_t& value) {
+    uint64_t digits = bytes_in_range(word, '0', '9');
+    uint64_t letters = bytes_in_range(word | (SWAR_ONES * 0x20), 'a', 'f');
+    uint64_t nibbles = (word & (SWAR_ONES * 0x0F)) + ((letters >> 7) * 9);
+
+    /* Pair up the nibbles, then the bytes, then byte-swap: the first character is the most
+     * significant nibble. */
+    nibbles = ((nibbles << 4) | (nibbles >> 8)) & 0x00FF00FF00FF00FFULL;
+    nibbles = (nibbles | (nibbles >> 8)) & 0x0000FFFF0000FFFFULL;
+    nibbles = (nibbles | (nibbles >> 16)) & 0x00000000FFFFFFFFULL;
+    value = __builtin_bswap32(static_cast<uint32_t>(nibbles));
+
+    return (word & SWAR_HIGH) == 0 && (digits | letters) == SWAR_HIGH;
+}
+
+static inline uint64_t hex_encode_word(const uint32_t value) {
+    uint64_t spread = __builtin_bswap32(value);
+
+    spread = (spread | (spread << 16)) & 0x0000FFFF0000FFFFULL;
+    spread = (spread | (spread << 8)) & 0x00FF00FF00FF00FFULL;
+    spread = ((spread >> 4) & 0x000F000F000F000FULL) | ((spread & 0x000F000F000F000FULL) << 8);
+
+    /* '0' + n, plus 7 more for n >= 10 to reach 'A'. */
+    return spread + (SWAR_ONES * '0') + (bytes_at_least(spread, 10) * 7);
+}
+
+/* Eight base64 characters to eight sextets, one per byte. */
+static inline bool base64_decode_word(const uint64_t word, uint64_t& sextets) {
+    uint64_t upper = bytes_in_range(word, 'A', 'Z'), lower = bytes_in_range(word, 'a', 'z');
+    uint64_t digits = bytes_in_range(word, '0', '9'), plus = bytes_in_range(word, '+', '+');
+    uint64_t slash = bytes_in_range(word, '/', '/');
+
+    /* Widen each 0x80 flag to a 0xFF byte mask; every byte sits in exactly one class, so the
+     * masked subtractions cannot borrow across bytes. */
+    uint64_t upper_mask = (upper >> 7) * 0xFF, lower_mask = (lower >> 7) * 0xFF, digits_mask = (digits >> 7) * 0xFF;
+    sextets = ((word & upper_mask) - ((SWAR_ONES * 'A') & upper_mask))
+            | ((word & lower_mask) - ((SWAR_ONES * ('a' - 26)) & lower_mask))
+            | ((word & digits_mask) + ((SWAR_ONES * (52 - '0')) & digits_mask))
+            | ((plus >> 7) * 62) | ((slash >> 7) * 63);
+
+    return (word & SWAR_HIGH) == 0 && (upper | lower | digits | plus | slash) == SWAR_HIGH;
+}
+
+/* Eight sextets (one per byte) to base64 characters: 'A' + v, moved up for the lower case
+ * letters and down for the digits, '+' and '/'. The additions come first so no byte ever
+ * borrows. */
+static inline uint64_t base64_encode_word(const uint64_t sextets) {
+    uint64_t text = sextets + (SWAR_ONES * 'A') + (bytes_at_least(sextets, 26) * 6) + (bytes_at_least(sextets, 63) * 3);
+    return text - (bytes_at_least(sextets, 52) * 75) - (bytes_at_least(sextets, 62) * 15);
+}
@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ * \file       des_codec.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the block text codecs
+ * \details    Converts 64-bit blocks to and from 16 hex digits or 12 base64 characters
+ *             (RFC 4648, one '=' of padding). Eight characters are handled at a time in a
+ *             64-bit word (SWAR), with no per-character branches or stream operations.
+ ******************************************************************************
+*/
+#ifndef DES_CODEC_H
+#define	DES_CODEC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_HEX_BLOCK_CHARS     16
+#define DES_BASE64_BLOCK_CHARS  12
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef enum {
+    DES_CODEC_HEX,
+    DES_CODEC_BASE64,
+    DES_CODEC_RAW
+} des_codec_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+bool des_codec_from_string(const string& name, des_codec_t& codec);
+
+/* Characters of one encoded block: 16, 12 or 8 (raw big-endian bytes). */
+size_t des_codec_block_chars(const des_codec_t codec);
+
+/* Hex is written in upper case and read in either case. Decoding returns false on any
+ * character outside the alphabet and leaves block unspecified. */
+void des_hex_encode_block(const uint64_t block, char* text);
+bool des_hex_decode_block(const char* text, uint64_t& block);
+
+/* Only the canonical form is accepted: the last character is '=' and the unused two bits of
+ * the one before it are zero. */
+void des_base64_encode_block(const uint64_t block, char* text);
+bool des_base64_decode_block(const char* text, uint64_t& block);
+
+/* Dispatch on the codec; text holds des_codec_block_chars(codec) characters. */
+void des_codec_encode_block(const des_codec_t codec, const uint64_t block, char* text);
+bool des_codec_decode_block(const des_codec_t codec, const char* text, uint64_t& block);
+
+#endif	/* DES_CODEC_H */
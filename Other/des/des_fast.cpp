@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * \file       des_fast.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the table-driven des engine
+ ******************************************************************************
+*/
+#include "des_fast.h"
+
+/* Static Functions Declarations --------------------------------------------*/
+static uint64_t des_fast_process_block(const uint64_t message, const des_fast_key_t& key_context, bool decrypt);
+static uint64_t des3_fast_process_block(const uint64_t message, const des3_fast_key_t& key_context, bool decrypt);
+static inline void des_fast_store_subkey(des_fast_key_t& key_context, const uint8_t round, const uint64_t k);
+
+/* Function Definitions -----------------------------------------------------*/
+void des_fast_key_setup(des_fast_key_t& key_context, const uint64_t key) {
+    uint64_t pc1_permuted = permute_bytes(key, PC1_BYTES);
+    uint32_t c = static_cast<uint32_t>(pc1_permuted >> 28), d = static_cast<uint32_t>(pc1_permuted & 0x0FFFFFFF);
+
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        /* Rotate both 28-bit halves by the total shift up to this round, then apply PC-2 to
+         * the concatenated C and D. No round depends on the previous one. */
+        uint8_t n = KEY_ROTATIONS.total[i];
+        uint32_t c_i = ((c << n) | (c >> (28 - n))) & 0x0FFFFFFF;
+        uint32_t d_i = ((d << n) | (d >> (28 - n))) & 0x0FFFFFFF;
+
+        des_fast_store_subkey(key_context, i, permute_bytes((static_cast<uint64_t>(c_i) << 28) | d_i, PC2_BYTES));
+    }
+}
+
+void des_fast_key_setup_ct(des_fast_key_t& key_context, const uint64_t key) {
+    uint64_t pc1_permuted = permute_word<64, 56, PC1>(key);
+    uint32_t c = static_cast<uint32_t>(pc1_permuted >> 28), d = static_cast<uint32_t>(pc1_permuted & 0x0FFFFFFF);
+
+    /* Same schedule as des_fast_key_setup, with PC-1 and PC-2 as compiled shift programs
+     * instead of byte tables indexed by key bytes. The rotation amounts are public. */
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        uint8_t n = KEY_ROTATIONS.total[i];
+        uint32_t c_i = ((c << n) | (c >> (28 - n))) & 0x0FFFFFFF;
+        uint32_t d_i = ((d << n) | (d >> (28 - n))) & 0x0FFFFFFF;
+
+        des_fast_store_subkey(key_context, i, permute_word<56, 48, PC2>((static_cast<uint64_t>(c_i) << 28) | d_i));
+    }
+}
+
+uint32_t function_f_fast(const uint32_t r, const uint32_t k[2]) {
+    /* The E expansion only duplicates neighbouring bits: rotating R right by one puts the
+     * groups of S1, S3, S5 and S7 side by side, and a further rotation left by four does the
+     * same for S2, S4, S6 and S8. */
+    uint32_t even = ((r >> 1) | (r << 31)) ^ k[0];
+    uint32_t odd = ((r << 3) | (r >> 29)) ^ k[1];
+
+    return SP_BOXES[0][(even >> 26) & 0x3F] | SP_BOXES[2][(even >> 18) & 0x3F]
+         | SP_BOXES[4][(even >> 10) & 0x3F] | SP_BOXES[6][(even >> 2) & 0x3F]
+         | SP_BOXES[1][(odd >> 26) & 0x3F] | SP_BOXES[3][(odd >> 18) & 0x3F]
+         | SP_BOXES[5][(odd >> 10) & 0x3F] | SP_BOXES[7][(odd >> 2) & 0x3F];
+}
+
+uint64_t des_fast_encrypt_block(const uint64_t message, const des_fast_key_t& key_context) {
+    return des_fast_process_block(message, key_context, false);
+}
+
+uint64_t des_fast_decrypt_block(const uint64_t ciphertext, const des_fast_key_t& key_context) {
+    return des_fast_process_block(ciphertext, key_context, true);
+}
+
+void des3_fast_key_setup(des3_fast_key_t& key_context, const uint64_t key1, const uint64_t key2, const uint64_t key3) {
+    des_fast_key_setup(key_context.keys[0], key1);
+    des_fast_key_setup(key_context.keys[1], key2);
+    des_fast_key_setup(key_context.keys[2], key3);
+}
+
+uint64_t des3_fast_encrypt_block(const uint64_t message, const des3_fast_key_t& key_context) {
+    return des3_fast_process_block(message, key_context, false);
+}
+
+uint64_t des3_fast_decrypt_block(const uint64_t ciphertext, const des3_fast_key_t& key_context) {
+    return des3_fast_process_block(ciphertext, key_context, true);
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static inline void des_fast_store_subkey(des_fast_key_t& key_context, const uint8_t round, const uint64_t k) {
+    /* Split the 48-bit subkey into its eight 6-bit groups and pack them like the expanded R. */
+    key_context.round_keys[round] = k;
+    key_context.subkeys[round][0] = key_context.subkeys[round][1] = 0;
+    for (uint8_t j = 0; j < 8; j++) {
+        uint32_t group = (k >> (42 - (6 * j))) & 0x3F;
+        key_context.subkeys[round][j & 1] |= group << (26 - (8 * (j >> 1)));
+    }
+}
+
+/* The 16 rounds without IP / IP-1. On return l and r hold R16 and L16, i.e. the halves of
+ * the pre-output block, which is also what the next DES stage expects after IP cancels IP-1.
+ * Rounds go in pairs so the halves never swap, and the direction is a template argument, so
+ * the fully unrolled rounds read their subkeys at fixed offsets and L and R stay in registers. */
+template<bool decrypt>
+static inline __attribute__((always_inline)) void des_fast_feistel(uint32_t& l, uint32_t& r, const des_fast_key_t& key_context) {
+    uint32_t left = l, right = r;
+
+#pragma GCC unroll 8
+    for (uint8_t i = 0; i < DES_ROUNDS; i += 2) {
+        left ^= function_f_fast(right, key_context.subkeys[decrypt ? (DES_ROUNDS - 1 - i) : i]);
+        right ^= function_f_fast(left, key_context.subkeys[decrypt ? (DES_ROUNDS - 2 - i) : (i + 1)]);
+    }
+
+    l = right;
+    r = left;
+}
+
+static inline void des_fast_feistel(uint32_t& l, uint32_t& r, const des_fast_key_t& key_context, bool decrypt) {
+    if (decrypt) {
+        des_fast_feistel<true>(l, r, key_context);
+    }
+    else {
+        des_fast_feistel<false>(l, r, key_context);
+    }
+}
+
+static uint64_t des_fast_process_block(const uint64_t message, const des_fast_key_t& key_context, bool decrypt) {
+    uint64_t ip_permuted = permute_bytes(message, IP_BYTES);
+    uint32_t l = static_cast<uint32_t>(ip_permuted >> 32), r = static_cast<uint32_t>(ip_permuted);
+
+    des_fast_feistel(l, r, key_context, decrypt);
+
+    /* R16 goes to the upper half and L16 to the lower half before the final permutation. */
+    return permute_bytes((static_cast<uint64_t>(l) << 32) | r, IP_INV_BYTES);
+}
+
+static uint64_t des3_fast_process_block(const uint64_t message, const des3_fast_key_t& key_context, bool decrypt) {
+    uint64_t ip_permuted = permute_bytes(message, IP_BYTES);
+    uint32_t l = static_cast<uint32_t>(ip_permuted >> 32), r = static_cast<uint32_t>(ip_permuted);
+
+    /* E(K3, D(K2, E(K1, x))) and its inverse D(K1, E(K2, D(K3, y))). The IP-1 of one stage
+     * and the IP of the next cancel, so only the outer permutations are applied. */
+    if (decrypt) {
+        des_fast_feistel(l, r, key_context.keys[2], true);
+        des_fast_feistel(l, r, key_context.keys[1], false);
+        des_fast_feistel(l, r, key_context.keys[0], true);
+    }
+    else {
+        des_fast_feistel(l, r, key_context.keys[0], false);
+        des_fast_feistel(l, r, key_context.keys[1], true);
+        des_fast_feistel(l, r, key_context.keys[2], false);
+    }
+
+    return permute_bytes((static_cast<uint64_t>(l) << 32) | r, IP_INV_BYTES);
+}
@@ -0,0 +1,162 @@
+/**
+ ******************************************************************************
+ * \file       des_fast.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the table-driven des engine
+ * \details    The fast engine works on packed integers instead of bitsets. The S-boxes
+ *             and the P permutation are fused into eight 64-entry SP tables, so a round
+ *             is eight table lookups and a few shifts and XORs. All of its tables are
+ *             constexpr, generated by the compiler from the ones in des_tables.h.
+ ******************************************************************************
+*/
+#ifndef DES_FAST_H
+#define	DES_FAST_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des.h"
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* Each subkey is stored as two words lining up with the even (S1, S3, S5, S7) and odd
+ * (S2, S4, S6, S8) 6-bit groups of the expanded R half, see function_f_fast. The plain
+ * 48-bit subkeys are kept as well for the bitsliced engine. */
+typedef struct {
+    uint32_t subkeys[DES_ROUNDS][2];
+    uint64_t round_keys[DES_ROUNDS];
+} des_fast_key_t;
+
+/* Triple DES (EDE): three independent schedules for EDE3, or keys[2] == keys[0] for EDE2. */
+typedef struct {
+    des_fast_key_t keys[3];
+} des3_fast_key_t;
+
+/* A bit permutation compiled into per-byte lookup tables: entry [j][v] holds the output
+ * bits contributed by input byte j (most significant first) having the value v. */
+typedef struct {
+    uint8_t input_bytes;
+    uint64_t table[8][256];
+} byte_permutation_t;
+
+typedef struct {
+    uint32_t table[8][64];
+} sp_boxes_t;
+
+/* Left rotation of C and D before round i, counted from C0 / D0, so every subkey can be
+ * derived straight from the PC-1 halves. */
+typedef struct {
+    uint8_t total[DES_ROUNDS];
+} key_rotations_t;
+
+/* bit[i][j] is the key bit (1..64, parity bits never appear) that becomes bit j + 1 of the
+ * round i + 1 subkey: the whole key schedule as wiring, for engines with one key per lane. */
+typedef struct {
+    uint8_t bit[DES_ROUNDS][48];
+} key_schedule_bits_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Integer counterpart of permute() that can run at compile time. */
+constexpr uint64_t permute_bits(const uint64_t input, const uint8_t input_size, const uint8_t* table, const uint8_t output_size) {
+    uint64_t output = 0;
+    for (uint8_t i = 0; i < output_size; i++) {
+        output |= ((input >> (input_size - table[i])) & 1) << (output_size - 1 - i);
+    }
+    return output;
+}
+
+constexpr byte_permutation_t byte_permutation_generator(const uint8_t input_size, const uint8_t* table, const uint8_t output_size) {
+    byte_permutation_t permutation = {};
+
+    permutation.input_bytes = input_size / 8;
+
+    /* Output bit i (counted from the MSB) comes from input bit table[i]; record it in the
+     * entries of the input byte holding that bit for every value where the bit is set. */
+    for (uint8_t i = 0; i < output_size; i++) {
+        uint8_t byte = (table[i] - 1) / 8;
+        uint8_t mask = 0x80 >> ((table[i] - 1) % 8);
+
+        for (uint16_t v = 0; v < 256; v++) {
+            if (v & mask) {
+                permutation.table[byte][v] |= 1ULL << (output_size - 1 - i);
+            }
+        }
+    }
+    return permutation;
+}
+
+constexpr sp_boxes_t sp_boxes_generator() {
+    sp_boxes_t sp = {};
+
+    /* SP[i][b] = P(S_i(b)) with the S-box output placed at its position in the 32-bit word. */
+    for (uint8_t i = 0; i < 8; i++) {
+        for (uint8_t b = 0; b < 64; b++) {
+            uint8_t row = ((b >> 4) & 0x02) | (b & 0x01);
+            uint8_t column = (b >> 1) & 0x0F;
+            uint64_t s = static_cast<uint64_t>(S_BOXES[i][row][column]) << (28 - (4 * i));
+
+            sp.table[i][b] = static_cast<uint32_t>(permute_bits(s, 32, P, 32));
+        }
+    }
+    return sp;
+}
+
+constexpr key_rotations_t key_rotations_generator() {
+    key_rotations_t rotations = {};
+    uint8_t total = 0;
+
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        total += ITERATIONS_LEFT_SHIFT[i];
+        rotations.total[i] = total % 28;
+    }
+    return rotations;
+}
+
+constexpr key_schedule_bits_t key_schedule_bits_generator() {
+    key_schedule_bits_t schedule = {};
+    key_rotations_t rotations = key_rotations_generator();
+
+    /* Subkey bit j is bit PC2[j] of C_i D_i; undo the rotation of its half to find the bit of
+     * C0 D0 it started as, and PC-1 names the key bit behind that. */
+    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+        for (uint8_t j = 0; j < 48; j++) {
+            uint8_t position = PC2[j] - 1;
+            uint8_t half = (position < 28) ? 0 : 28;
+            uint8_t source = half + (((position - half) + rotations.total[i]) % 28);
+            schedule.bit[i][j] = PC1[source];
+        }
+    }
+    return schedule;
+}
+
+/* Variables Definitions ----------------------------------------------------*/
+inline constexpr sp_boxes_t SP_BOXES_TABLE = sp_boxes_generator();
+inline constexpr const uint32_t (&SP_BOXES)[8][64] = SP_BOXES_TABLE.table;
+inline constexpr byte_permutation_t IP_BYTES = byte_permutation_generator(64, IP, 64);
+inline constexpr byte_permutation_t IP_INV_BYTES = byte_permutation_generator(64, IP_INV, 64);
+inline constexpr byte_permutation_t PC1_BYTES = byte_permutation_generator(64, PC1, 56);
+inline constexpr byte_permutation_t PC2_BYTES = byte_permutation_generator(56, PC2, 48);
+inline constexpr key_rotations_t KEY_ROTATIONS = key_rotations_generator();
+inline constexpr key_schedule_bits_t KEY_SCHEDULE_BITS = key_schedule_bits_generator();
+
+inline uint64_t permute_bytes(const uint64_t input, const byte_permutation_t& permutation) {
+    uint64_t output = 0;
+    for (uint8_t j = 0; j < permutation.input_bytes; j++) {
+        output |= permutation.table[j][(input >> (8 * (permutation.input_bytes - 1 - j))) & 0xFF];
+    }
+    return output;
+}
+
+void des_fast_key_setup(des_fast_key_t& key_context, const uint64_t key);
+
+/* The same key context without key-indexed table lookups, for the constant-time engine
+ * (des_bitslice_*_blocks). The lookups of des_fast_key_setup leak key bits through the cache. */
+void des_fast_key_setup_ct(des_fast_key_t& key_context, const uint64_t key);
+
+uint32_t function_f_fast(const uint32_t r, const uint32_t k[2]);
+
+uint64_t des_fast_encrypt_block(const uint64_t message, const des_fast_key_t& key_context);
+uint64_t des_fast_decrypt_block(const uint64_t ciphertext, const des_fast_key_t& key_context);
+
+void des3_fast_key_setup(des3_fast_key_t& key_context, const uint64_t key1, const uint64_t key2, const uint64_t key3);
+uint64_t des3_fast_encrypt_block(const uint64_t message, const des3_fast_key_t& key_context);
+uint64_t des3_fast_decrypt_block(const uint64_t ciphertext, const des3_fast_key_t& key_context);
+
+#endif	/* DES_FAST_H */
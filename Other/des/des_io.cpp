@@ -0,0 +1,546 @@
+/**
+ ******************************************************************************
+ * \file       des_io.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of streaming file encryption
+ ******************************************************************************
+*/
+#include "des_io.h"
+#include "des_pipeline.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* Output is produced straight into one large buffer and handed to write(2) when it fills. */
+typedef struct {
+    int fd;
+    vector<uint8_t> buffer;
+    size_t used;
+} des_output_t;
+
+/* A unit of work travelling through the pipeline. `input` has DES_BLOCK_BYTES * 2 bytes of
+ * headroom in front of the data so the cipher stage can prepend the previous batch's unprocessed
+ * tail without moving the batch. */
+typedef struct {
+    vector<uint8_t> input;
+    size_t length;
+    des_output_t output;
+    bool eof;
+    bool failed;
+} des_batch_t;
+
+typedef des_spsc_ring<des_batch_t*, DES_IO_PIPELINE_BATCHES> des_batch_ring_t;
+
+/* Static Functions Declarations --------------------------------------------*/
+static bool write_all(int fd, const uint8_t* data, size_t length, string& error);
+static bool output_flush(des_output_t& output, string& error);
+static uint8_t* output_reserve(des_output_t& output, size_t length, string& error);
+static ssize_t read_full(int fd, uint8_t* data, size_t length);
+static bool open_files(const string& input_path, const string& output_path, int& input_fd, int& output_fd, string& error);
+static void close_files(int input_fd, int output_fd);
+static bool parse_records(const des_codec_t codec, bool keyed, const uint8_t* data, size_t length, bool eof, vector<uint64_t>& blocks, vector<uint64_t>& keys, size_t& consumed, size_t& line, string& error);
+static bool write_records(const des_codec_t codec, const vector<uint64_t>& blocks, des_output_t& output, string& error);
+template<typename cipher_t>
+static bool des_batch_process_impl(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, bool keyed, cipher_t cipher, string& error);
+template<typename key_t>
+static bool des_pipeline_process(int input_fd, int output_fd, des_stream_t& stream, const key_t& key_context, bool decrypt, string& error);
+template<typename key_t>
+static bool process_available(des_stream_t& stream, const key_t& key_context, bool decrypt, const uint8_t* data, size_t available, bool eof, size_t& consumed, des_output_t& output, string& error);
+template<typename key_t>
+static bool des_file_process_impl(const string& input_path, const string& output_path, const des_mode_t mode, const key_t& key_context, const uint64_t iv, bool decrypt, string& error);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_file_process(const string& input_path, const string& output_path, const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, bool decrypt, string& error) {
+    return des_file_process_impl(input_path, output_path, mode, key_context, iv, decrypt, error);
+}
+
+bool des_file_process(const string& input_path, const string& output_path, const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, bool decrypt, string& error) {
+    return des_file_process_impl(input_path, output_path, mode, key_context, iv, decrypt, error);
+}
+
+bool des_batch_process(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, const des_fast_key_t& key_context, bool decrypt, string& error) {
+    return des_batch_process_impl(input_path, output_path, input_codec, output_codec, false, [&](const uint64_t* input, const uint64_t*, uint64_t* output, size_t count) {
+        if (decrypt) {
+            des_decrypt_blocks(input, output, count, key_context);
+        }
+        else {
+            des_encrypt_blocks(input, output, count, key_context);
+        }
+    }, error);
+}
+
+bool des_batch_process(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, const des3_fast_key_t& key_context, bool decrypt, string& error) {
+    return des_batch_process_impl(input_path, output_path, input_codec, output_codec, false, [&](const uint64_t* input, const uint64_t*, uint64_t* output, size_t count) {
+        if (decrypt) {
+            des_decrypt_blocks(input, output, count, key_context);
+        }
+        else {
+            des_encrypt_blocks(input, output, count, key_context);
+        }
+    }, error);
+}
+
+bool des_batch_process_keyed(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, bool decrypt, string& error) {
+    return des_batch_process_impl(input_path, output_path, input_codec, output_codec, true, [&](const uint64_t* input, const uint64_t* keys, uint64_t* output, size_t count) {
+        if (decrypt) {
+            des_multi_key_decrypt(keys, count, input, 1, output);
+        }
+        else {
+            des_multi_key_encrypt(keys, count, input, 1, output);
+        }
+    }, error);
+}
+
+bool des_batch_process_keyed(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, des_key_cache& cache, bool decrypt, string& error) {
+    return des_batch_process_impl(input_path, output_path, input_codec, output_codec, true, [&](const uint64_t* input, const uint64_t* keys, uint64_t* output, size_t count) {
+        if (decrypt) {
+            des_multi_key_decrypt(keys, count, input, 1, output, cache);
+        }
+        else {
+            des_multi_key_encrypt(keys, count, input, 1, output, cache);
+        }
+    }, error);
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static bool write_all(int fd, const uint8_t* data, size_t length, string& error) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = string("write failed: ") + strerror(errno);
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool output_flush(des_output_t& output, string& error) {
+    bool ok = write_all(output.fd, output.buffer.data(), output.used, error);
+    output.used = 0;
+    return ok;
+}
+
+static uint8_t* output_reserve(des_output_t& output, size_t length, string& error) {
+    if (output.used + length > output.buffer.size() && !output_flush(output, error)) {
+        return nullptr;
+    }
+    return output.buffer.data() + output.used;
+}
+
+static ssize_t read_full(int fd, uint8_t* data, size_t length) {
+    size_t total = 0;
+
+    while (total < length) {
+        ssize_t n = read(fd, data + total, length - total);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+/* Process as many whole blocks of data[0..available) as can be finalised now and report how
+ * many bytes were consumed. Before EOF a partial block is left for the next call, and so is
+ * the last whole block when decrypting a padded mode, since it may carry the padding. */
+template<typename key_t>
+static bool process_available(des_stream_t& stream, const key_t& key_context, bool decrypt, const uint8_t* data, size_t available, bool eof, size_t& consumed, des_output_t& output, string& error) {
+    bool padded = des_mode_is_padded(stream.mode);
+    size_t keep = available % DES_BLOCK_BYTES;
+
+    if (decrypt && padded && keep == 0 && available > 0) {
+        keep = DES_BLOCK_BYTES;
+    }
+
+    consumed = 0;
+    while (consumed + keep < available) {
+        size_t length = available - keep - consumed;
+        if (length > output.buffer.size()) {
+            length = output.buffer.size();
+        }
+
+        uint8_t* out = output_reserve(output, length, error);
+        if (out == nullptr) {
+            return false;
+        }
+        if (decrypt) {
+            des_stream_decrypt_blocks(stream, key_context, data + consumed, out, length / DES_BLOCK_BYTES);
+        }
+        else {
+            des_stream_encrypt_blocks(stream, key_context, data + consumed, out, length / DES_BLOCK_BYTES);
+        }
+        output.used += length;
+        consumed += length;
+    }
+
+    if (!eof) {
+        return true;
+    }
+
+    /* End of stream: `keep` bytes are left. */
+    uint8_t last[DES_BLOCK_BYTES];
+    uint8_t* out = output_reserve(output, DES_BLOCK_BYTES, error);
+    if (out == nullptr) {
+        return false;
+    }
+
+    if (padded && !decrypt) {
+        memcpy(last, data + consumed, keep);
+        memset(last + keep, DES_BLOCK_BYTES - keep, DES_BLOCK_BYTES - keep);
+        des_stream_encrypt_blocks(stream, key_context, last, out, 1);
+        output.used += DES_BLOCK_BYTES;
+    }
+    else if (padded) {
+        if (keep != DES_BLOCK_BYTES) {
+            error = "ciphertext is not a whole number of blocks";
+            return false;
+        }
+        des_stream_decrypt_blocks(stream, key_context, data + consumed, last, 1);
+
+        uint8_t padding = last[DES_BLOCK_BYTES - 1];
+        if (padding == 0 || padding > DES_BLOCK_BYTES) {
+            error = "bad padding";
+            return false;
+        }
+        for (uint8_t i = DES_BLOCK_BYTES - padding; i < DES_BLOCK_BYTES; i++) {
+            if (last[i] != padding) {
+                error = "bad padding";
+                return false;
+            }
+        }
+        memcpy(out, last, DES_BLOCK_BYTES - padding);
+        output.used += DES_BLOCK_BYTES - padding;
+    }
+    else if (keep > 0) {
+        des_stream_final(stream, key_context, data + consumed, out, keep, decrypt);
+        output.used += keep;
+    }
+
+    consumed = available;
+    return true;
+}
+
+static bool open_files(const string& input_path, const string& output_path, int& input_fd, int& output_fd, string& error) {
+    input_fd = STDIN_FILENO;
+    if (input_path != "-") {
+        input_fd = open(input_path.c_str(), O_RDONLY);
+        if (input_fd < 0) {
+            error = input_path + ": " + strerror(errno);
+            return false;
+        }
+    }
+
+    output_fd = STDOUT_FILENO;
+    if (output_path != "-") {
+        output_fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (output_fd < 0) {
+            error = output_path + ": " + strerror(errno);
+            if (input_fd != STDIN_FILENO) {
+                close(input_fd);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static void close_files(int input_fd, int output_fd) {
+    if (input_fd != STDIN_FILENO) {
+        close(input_fd);
+    }
+    if (output_fd != STDOUT_FILENO) {
+        close(output_fd);
+    }
+}
+
+template<typename key_t>
+static bool des_file_process_impl(const string& input_path, const string& output_path, const des_mode_t mode, const key_t& key_context, const uint64_t iv, bool decrypt, string& error) {
+    des_stream_t stream = { mode, iv };
+    des_output_t output;
+    struct stat input_stat;
+    bool ok = true;
+    int input_fd;
+    size_t consumed = 0;
+
+    if (!open_files(input_path, output_path, input_fd, output.fd, error)) {
+        return false;
+    }
+    output.buffer.resize(DES_IO_CHUNK_BYTES);
+    output.used = 0;
+
+    if (fstat(input_fd, &input_stat) == 0 && S_ISREG(input_stat.st_mode) && input_stat.st_size > 0) {
+        /* Regular file: map it and walk the mapping; the kernel reads ahead for us. */
+        size_t size = static_cast<size_t>(input_stat.st_size);
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, input_fd, 0);
+
+        if (map == MAP_FAILED) {
+            error = input_path + ": " + strerror(errno);
+            ok = false;
+        }
+        else {
+            const uint8_t* data = static_cast<const uint8_t*>(map);
+            size_t offset = 0;
+
+            madvise(map, size, MADV_SEQUENTIAL);
+            while (ok && offset < size) {
+                size_t available = (size - offset < DES_IO_CHUNK_BYTES) ? (size - offset) : DES_IO_CHUNK_BYTES;
+
+                /* The mapping is contiguous, so bytes left unconsumed simply start the next slice. */
+                ok = process_available(stream, key_context, decrypt, data + offset, available, offset + available == size, consumed, output, error);
+                offset += consumed;
+            }
+            munmap(map, size);
+        }
+    }
+    else {
+        /* Pipe or empty file: overlap reading, encryption and writing. */
+        ok = des_pipeline_process(input_fd, output.fd, stream, key_context, decrypt, error);
+    }
+
+    if (ok) {
+        ok = output_flush(output, error);
+    }
+    close_files(input_fd, output.fd);
+    return ok;
+}
+
+/* Decode the whole records of data[0..length) into blocks (and keys). Before EOF a line
+ * without its newline, or a partial raw record, is left unconsumed for the next call. */
+static bool parse_records(const des_codec_t codec, bool keyed, const uint8_t* data, size_t length, bool eof, vector<uint64_t>& blocks, vector<uint64_t>& keys, size_t& consumed, size_t& line, string& error) {
+    const char* text = reinterpret_cast<const char*>(data);
+    size_t width = des_codec_block_chars(codec);
+
+    blocks.clear();
+    keys.clear();
+
+    if (codec == DES_CODEC_RAW) {
+        size_t record = keyed ? 2 * DES_BLOCK_BYTES : DES_BLOCK_BYTES;
+
+        consumed = length - (length % record);
+        if (eof && consumed != length) {
+            error = keyed ? "input is not a whole number of block and key records" : "input is not a whole number of blocks";
+            return false;
+        }
+        for (size_t offset = 0; offset < consumed; offset += record) {
+            blocks.push_back(load_block(data + offset));
+            if (keyed) {
+                keys.push_back(load_block(data + offset + DES_BLOCK_BYTES));
+            }
+        }
+        return true;
+    }
+
+    consumed = 0;
+    while (consumed < length) {
+        const char* newline = static_cast<const char*>(memchr(text + consumed, '\n', length - consumed));
+        if (newline == nullptr && !eof) {
+            break;
+        }
+
+        size_t end = (newline == nullptr) ? length : static_cast<size_t>(newline - text);
+        size_t next = (newline == nullptr) ? length : end + 1;
+        const char* record = text + consumed;
+        size_t record_length = end - consumed;
+        uint64_t block, key;
+
+        if (record_length > 0 && record[record_length - 1] == '\r') {
+            record_length--;
+        }
+        if (record_length > 0) {
+            bool ok;
+
+            if (keyed) {
+                char separator = (record_length == (2 * width) + 1) ? record[width] : 0;
+                ok = (separator == ' ' || separator == '\t' || separator == ',')
+                     && des_codec_decode_block(codec, record, block) && des_codec_decode_block(codec, record + width + 1, key);
+            }
+            else {
+                ok = record_length == width && des_codec_decode_block(codec, record, block);
+            }
+            if (!ok) {
+                error = "line " + to_string(line) + ": expected " + (keyed ? "<block> <key>" : "a block") + " of " + to_string(width) + (codec == DES_CODEC_HEX ? " hex digits" : " base64 characters");
+                return false;
+            }
+            blocks.push_back(block);
+            if (keyed) {
+                keys.push_back(key);
+            }
+        }
+        consumed = next;
+        line++;
+    }
+    return true;
+}
+
+static bool write_records(const des_codec_t codec, const vector<uint64_t>& blocks, des_output_t& output, string& error) {
+    size_t width = des_codec_block_chars(codec);
+    size_t record = (codec == DES_CODEC_RAW) ? width : width + 1;
+
+    for (uint64_t block : blocks) {
+        uint8_t* out = output_reserve(output, record, error);
+        if (out == nullptr) {
+            return false;
+        }
+        des_codec_encode_block(codec, block, reinterpret_cast<char*>(out));
+        if (codec != DES_CODEC_RAW) {
+            out[width] = '\n';
+        }
+        output.used += record;
+    }
+    return true;
+}
+
+/* Read a large slice, decode every whole record in it, run them through cipher in one call and
+ * encode the results straight into the output buffer; the unfinished tail moves to the front. */
+template<typename cipher_t>
+static bool des_batch_process_impl(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, bool keyed, cipher_t cipher, string& error) {
+    vector<uint8_t> input(DES_IO_CHUNK_BYTES);
+    vector<uint64_t> blocks, keys, results;
+    des_output_t output;
+    size_t filled = 0, line = 1;
+    bool ok = true, eof = false;
+    int input_fd;
+
+    if (!open_files(input_path, output_path, input_fd, output.fd, error)) {
+        return false;
+    }
+    output.buffer.resize(DES_IO_CHUNK_BYTES);
+    output.used = 0;
+
+    while (ok && !eof) {
+        ssize_t n = read_full(input_fd, input.data() + filled, input.size() - filled);
+        size_t consumed = 0;
+
+        if (n < 0) {
+            error = string("read failed: ") + strerror(errno);
+            ok = false;
+            break;
+        }
+        eof = filled + static_cast<size_t>(n) < input.size();
+        filled += static_cast<size_t>(n);
+
+        ok = parse_records(input_codec, keyed, input.data(), filled, eof, blocks, keys, consumed, line, error);
+        if (ok && consumed == 0 && !eof) {
+            error = "line " + to_string(line) + ": line too long";
+            ok = false;
+        }
+        if (ok) {
+            results.resize(blocks.size());
+            cipher(blocks.data(), keys.data(), results.data(), blocks.size());
+            ok = write_records(output_codec, results, output, error);
+        }
+
+        memmove(input.data(), input.data() + consumed, filled - consumed);
+        filled -= consumed;
+    }
+
+    if (ok) {
+        ok = output_flush(output, error);
+    }
+    close_files(input_fd, output.fd);
+    return ok;
+}
+
+/* Reader thread -> cipher stage (this thread, parallel inside des_stream_*_blocks) -> writer
+ * thread. Batches are recycled from the writer back to the reader through a third ring. */
+template<typename key_t>
+static bool des_pipeline_process(int input_fd, int output_fd, des_stream_t& stream, const key_t& key_context, bool decrypt, string& error) {
+    const size_t headroom = 2 * DES_BLOCK_BYTES;
+    vector<des_batch_t> batches(DES_IO_PIPELINE_BATCHES);
+    des_batch_ring_t free_batches, filled_batches, done_batches;
+    string read_error, write_error;
+    uint8_t carry[2 * DES_BLOCK_BYTES];
+    size_t carry_length = 0;
+    bool ok = true;
+
+    for (des_batch_t& batch : batches) {
+        batch.input.resize(headroom + DES_IO_BATCH_BYTES);
+        batch.output.fd = -1;
+        batch.output.buffer.resize(DES_IO_BATCH_BYTES + (4 * DES_BLOCK_BYTES));
+        free_batches.push(&batch);
+    }
+
+    thread reader([&] {
+        bool eof = false;
+
+        while (!eof) {
+            des_batch_t* batch = free_batches.pop();
+            ssize_t n = read_full(input_fd, batch->input.data() + headroom, DES_IO_BATCH_BYTES);
+
+            batch->failed = n < 0;
+            if (batch->failed) {
+                read_error = string("read failed: ") + strerror(errno);
+            }
+            batch->length = batch->failed ? 0 : static_cast<size_t>(n);
+            eof = batch->failed || batch->length < DES_IO_BATCH_BYTES;
+            batch->eof = eof;
+            filled_batches.push(batch);
+        }
+    });
+
+    thread writer([&] {
+        bool eof = false, failed = false;
+
+        while (!eof) {
+            des_batch_t* batch = done_batches.pop();
+            string stage_error;
+
+            if (!failed && !batch->failed && !write_all(output_fd, batch->output.buffer.data(), batch->output.used, stage_error)) {
+                write_error = stage_error;
+                failed = true;
+            }
+            batch->output.used = 0;
+            eof = batch->eof;
+            if (!eof) {
+                free_batches.push(batch);
+            }
+        }
+    });
+
+    bool eof = false;
+    while (!eof) {
+        des_batch_t* batch = filled_batches.pop();
+        uint8_t* data = batch->input.data() + headroom - carry_length;
+        size_t available = carry_length + batch->length, consumed = 0;
+
+        memcpy(data, carry, carry_length);
+        if (ok && !batch->failed) {
+            ok = process_available(stream, key_context, decrypt, data, available, batch->eof, consumed, batch->output, error);
+        }
+        batch->failed = batch->failed || !ok;
+
+        carry_length = available - consumed;
+        memcpy(carry, data + consumed, carry_length);
+        eof = batch->eof;
+        done_batches.push(batch);
+    }
+
+    reader.join();
+    writer.join();
+
+    if (!read_error.empty()) {
+        error = read_error;
+        return false;
+    }
+    if (!write_error.empty()) {
+        error = write_error;
+        return false;
+    }
+    return ok;
+}
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * \file       des_io.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for streaming file encryption
+ * \details    Whole files (memory-mapped) or pipes (read by a reader thread) are pushed through
+ *             a mode of operation in big batches and written with large unformatted writes.
+ *             For pipes, reading, encryption and writing run as three overlapping stages.
+ *             Batch mode handles many independent blocks given as hex or base64 lines or raw
+ *             records, optionally each with its own key.
+ ******************************************************************************
+*/
+#ifndef DES_IO_H
+#define	DES_IO_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_modes.h"
+#include "des_codec.h"
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_IO_CHUNK_BYTES      (4 * 1024 * 1024)
+
+/* Streamed input runs as a reader / cipher / writer pipeline over this many reusable batches. */
+#define DES_IO_BATCH_BYTES      (1024 * 1024)
+#define DES_IO_PIPELINE_BATCHES 8
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Encrypt or decrypt input_path into output_path ("-" is stdin / stdout). Padding is added
+ * or stripped at the end of the stream for ECB and CBC. Returns false and fills error on an
+ * I/O failure or, when decrypting, a bad final block. */
+bool des_file_process(const string& input_path, const string& output_path, const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, bool decrypt, string& error);
+bool des_file_process(const string& input_path, const string& output_path, const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, bool decrypt, string& error);
+
+/* Batch mode: every block is encrypted on its own (ECB without padding). Text input has one
+ * block per line, raw input back-to-back 8-byte blocks; empty lines are skipped and a trailing
+ * '\r' is ignored. Text output is one block per line. Returns false and fills error on an
+ * I/O failure or a malformed record. */
+bool des_batch_process(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, const des_fast_key_t& key_context, bool decrypt, string& error);
+bool des_batch_process(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, const des3_fast_key_t& key_context, bool decrypt, string& error);
+
+/* As above, but each record carries its own single DES key: "<block> <key>" (space, tab or
+ * comma in between, both in the input codec) or a raw block followed by a raw key. */
+bool des_batch_process_keyed(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, bool decrypt, string& error);
+
+/* Keyed batch mode with the schedules taken from cache instead of expanded per record; pays
+ * off when the records keep reusing a small set of keys. */
+bool des_batch_process_keyed(const string& input_path, const string& output_path, const des_codec_t input_codec, const des_codec_t output_codec, des_key_cache& cache, bool decrypt, string& error);
+
+#endif	/* DES_IO_H */
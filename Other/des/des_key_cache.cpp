@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * \file       des_key_cache.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the key schedule cache
+ ******************************************************************************
+*/
+#include "des_key_cache.h"
+
+/* Variables Definitions ----------------------------------------------------*/
+static mutex default_cache_lock;
+static unique_ptr<des_key_cache> default_cache;
+
+/* Function Definitions -----------------------------------------------------*/
+des_key_cache::des_key_cache(size_t capacity, size_t shard_count) {
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    if (shard_count == 0) {
+        shard_count = 1;
+    }
+    if (shard_count > capacity) {
+        shard_count = capacity;
+    }
+
+    for (size_t i = 0; i < shard_count; i++) {
+        shard_t* shard = new shard_t;
+
+        /* The first capacity % shard_count shards take one entry more. */
+        shard->capacity = (capacity / shard_count) + ((i < (capacity % shard_count)) ? 1 : 0);
+        shard->hits = 0;
+        shard->misses = 0;
+        shard->index.reserve(shard->capacity);
+        shards.emplace_back(shard);
+    }
+}
+
+void des_key_cache::get(const uint64_t key, des_fast_key_t& key_context) {
+    shard_t& shard = shard_of(key);
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+        auto found = shard.index.find(key);
+
+        if (found != shard.index.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+            key_context = found->second->second;
+            shard.hits++;
+            return;
+        }
+        shard.misses++;
+    }
+
+    /* Expanded unlocked; a thread racing on the same key inserts the same schedule. */
+    des_fast_key_setup(key_context, key);
+
+    lock_guard<mutex> guard(shard.lock);
+    if (shard.index.find(key) != shard.index.end()) {
+        return;
+    }
+    if (shard.entries.size() == shard.capacity) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    shard.entries.emplace_front(key, key_context);
+    shard.index[key] = shard.entries.begin();
+}
+
+uint64_t des_key_cache::hits() const {
+    uint64_t total = 0;
+
+    for (const unique_ptr<shard_t>& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        total += shard->hits;
+    }
+    return total;
+}
+
+uint64_t des_key_cache::misses() const {
+    uint64_t total = 0;
+
+    for (const unique_ptr<shard_t>& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        total += shard->misses;
+    }
+    return total;
+}
+
+size_t des_key_cache::size() const {
+    size_t total = 0;
+
+    for (const unique_ptr<shard_t>& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        total += shard->entries.size();
+    }
+    return total;
+}
+
+size_t des_key_cache::capacity() const {
+    size_t total = 0;
+
+    for (const unique_ptr<shard_t>& shard : shards) {
+        total += shard->capacity;
+    }
+    return total;
+}
+
+/* Drops the schedules; the counters keep running. */
+void des_key_cache::clear() {
+    for (unique_ptr<shard_t>& shard : shards) {
+        lock_guard<mutex> guard(shard->lock);
+        shard->index.clear();
+        shard->entries.clear();
+    }
+}
+
+des_key_cache::shard_t& des_key_cache::shard_of(const uint64_t key) {
+    /* DES keys often differ only in a few bytes (and never in the parity bits), so the key is
+     * mixed before the high bits pick the shard. */
+    uint64_t hash = (key ^ (key >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return *shards[(hash >> 32) % shards.size()];
+}
+
+des_key_cache& des_default_key_cache() {
+    lock_guard<mutex> guard(default_cache_lock);
+
+    if (!default_cache) {
+        default_cache.reset(new des_key_cache(DES_KEY_CACHE_ENTRIES));
+    }
+    return *default_cache;
+}
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * \file       des_key_cache.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the key schedule cache
+ * \details    A bounded LRU cache of expanded key schedules keyed by the 64-bit DES key, for
+ *             traffic that reuses a few keys many times. Keys are spread over shards by a
+ *             hash, each with its own lock, list and index, so threads working on different
+ *             keys rarely meet; a miss expands the key outside the lock.
+ ******************************************************************************
+*/
+#ifndef DES_KEY_CACHE_H
+#define	DES_KEY_CACHE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_fast.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_KEY_CACHE_SHARDS    16
+
+/* Capacity of the process-wide cache, about 1 MiB of schedules. */
+#define DES_KEY_CACHE_ENTRIES   4096
+
+/* Data Type Declarations ---------------------------------------------------*/
+class des_key_cache {
+public:
+    /* capacity is split evenly over the shards; fewer shards are used for tiny capacities. */
+    explicit des_key_cache(size_t capacity, size_t shard_count = DES_KEY_CACHE_SHARDS);
+
+    /* Copy the schedule of key into key_context, expanding and inserting it on a miss and
+     * evicting the least recently used key of its shard when that shard is full. */
+    void get(const uint64_t key, des_fast_key_t& key_context);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+
+private:
+    typedef list<pair<uint64_t, des_fast_key_t>> entry_list_t;
+
+    /* Most recently used entry at the front of `entries`. */
+    typedef struct {
+        mutable mutex lock;
+        entry_list_t entries;
+        unordered_map<uint64_t, entry_list_t::iterator> index;
+        size_t capacity;
+        uint64_t hits;
+        uint64_t misses;
+    } shard_t;
+
+    vector<unique_ptr<shard_t>> shards;
+
+    shard_t& shard_of(const uint64_t key);
+};
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Process-wide cache of DES_KEY_CACHE_ENTRIES schedules, created on first use. */
+des_key_cache& des_default_key_cache();
+
+#endif	/* DES_KEY_CACHE_H */
@@ -0,0 +1,500 @@
+/**
+ ******************************************************************************
+ * \file       des_modes.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the des modes of operation
+ ******************************************************************************
+*/
+#include "des_modes.h"
+#include "des_bitslice.h"
+#include "des_thread_pool.h"
+#include <cstring>
+
+/* Macro Declarations -------------------------------------------------------*/
+/* Blocks converted and encrypted per step: large enough for a full AVX-512 bitslice pass,
+ * small enough to stay on the stack and in L1. */
+#define DES_MODE_BATCH_BLOCKS   512
+
+/* Blocks per thread-pool task: 64 KiB of input, sized to stay in a core's L2. */
+#define DES_MODE_CHUNK_BLOCKS   8192
+
+/* Static Functions Declarations --------------------------------------------*/
+static void des_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt);
+static void des_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context, bool decrypt);
+template<typename key_t>
+static void des_process_blocks_threaded(const uint64_t* input, uint64_t* output, size_t count, const key_t& key_context, bool decrypt);
+static void des_multi_key_process(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache* cache, bool decrypt);
+static void des_multi_key_process_serial(const uint64_t* keys, size_t first_block, size_t count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache* cache, bool decrypt);
+
+/* Each mode is written once over the key type, so single DES and triple DES share it. */
+template<typename key_t>
+static void des_stream_encrypt_blocks_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+template<typename key_t>
+static void des_stream_decrypt_blocks_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+template<typename key_t>
+static void des_stream_final_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt);
+template<typename key_t>
+static void des_stream_encrypt_blocks_serial(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+template<typename key_t>
+static void des_stream_decrypt_blocks_serial(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+template<typename key_t>
+static size_t des_mode_encrypt_impl(const des_mode_t mode, const key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output);
+template<typename key_t>
+static bool des_mode_decrypt_impl(const des_mode_t mode, const key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_mode_from_string(const string& name, des_mode_t& mode) {
+    if (name == "ecb") {
+        mode = DES_MODE_ECB;
+    }
+    else if (name == "cbc") {
+        mode = DES_MODE_CBC;
+    }
+    else if (name == "cfb") {
+        mode = DES_MODE_CFB;
+    }
+    else if (name == "ofb") {
+        mode = DES_MODE_OFB;
+    }
+    else if (name == "ctr") {
+        mode = DES_MODE_CTR;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool des_mode_is_padded(const des_mode_t mode) {
+    return mode == DES_MODE_ECB || mode == DES_MODE_CBC;
+}
+
+void des_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context) {
+    des_process_blocks_threaded(input, output, count, key_context, false);
+}
+
+void des_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context) {
+    des_process_blocks_threaded(input, output, count, key_context, true);
+}
+
+void des_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context) {
+    des_process_blocks_threaded(input, output, count, key_context, false);
+}
+
+void des_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context) {
+    des_process_blocks_threaded(input, output, count, key_context, true);
+}
+
+void des_multi_key_encrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output) {
+    des_multi_key_process(keys, key_count, input, blocks_per_key, output, nullptr, false);
+}
+
+void des_multi_key_decrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output) {
+    des_multi_key_process(keys, key_count, input, blocks_per_key, output, nullptr, true);
+}
+
+void des_multi_key_encrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache& cache) {
+    des_multi_key_process(keys, key_count, input, blocks_per_key, output, &cache, false);
+}
+
+void des_multi_key_decrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache& cache) {
+    des_multi_key_process(keys, key_count, input, blocks_per_key, output, &cache, true);
+}
+
+void des_stream_encrypt_blocks(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    des_stream_encrypt_blocks_impl(stream, key_context, input, output, blocks);
+}
+
+void des_stream_decrypt_blocks(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    des_stream_decrypt_blocks_impl(stream, key_context, input, output, blocks);
+}
+
+void des_stream_final(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt) {
+    des_stream_final_impl(stream, key_context, input, output, length, decrypt);
+}
+
+size_t des_mode_encrypt(const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output) {
+    return des_mode_encrypt_impl(mode, key_context, iv, input, length, output);
+}
+
+bool des_mode_decrypt(const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length) {
+    return des_mode_decrypt_impl(mode, key_context, iv, input, length, output, output_length);
+}
+
+void des_stream_encrypt_blocks(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    des_stream_encrypt_blocks_impl(stream, key_context, input, output, blocks);
+}
+
+void des_stream_decrypt_blocks(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    des_stream_decrypt_blocks_impl(stream, key_context, input, output, blocks);
+}
+
+void des_stream_final(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt) {
+    des_stream_final_impl(stream, key_context, input, output, length, decrypt);
+}
+
+size_t des_mode_encrypt(const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output) {
+    return des_mode_encrypt_impl(mode, key_context, iv, input, length, output);
+}
+
+bool des_mode_decrypt(const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length) {
+    return des_mode_decrypt_impl(mode, key_context, iv, input, length, output, output_length);
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static inline uint64_t cipher_encrypt_block(const des_fast_key_t& key_context, const uint64_t block) {
+    return des_fast_encrypt_block(block, key_context);
+}
+
+static inline uint64_t cipher_encrypt_block(const des3_fast_key_t& key_context, const uint64_t block) {
+    return des3_fast_encrypt_block(block, key_context);
+}
+
+template<typename key_t>
+static void des_stream_encrypt_blocks_serial(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    uint64_t batch[DES_MODE_BATCH_BLOCKS];
+
+    for (size_t done = 0; done < blocks; done += DES_MODE_BATCH_BLOCKS) {
+        size_t n = (blocks - done < DES_MODE_BATCH_BLOCKS) ? (blocks - done) : DES_MODE_BATCH_BLOCKS;
+        const uint8_t* in = input + (done * DES_BLOCK_BYTES);
+        uint8_t* out = output + (done * DES_BLOCK_BYTES);
+
+        switch (stream.mode) {
+            case DES_MODE_ECB:
+                for (size_t i = 0; i < n; i++) {
+                    batch[i] = load_block(in + (i * DES_BLOCK_BYTES));
+                }
+                des_encrypt_blocks(batch, batch, n, key_context);
+                for (size_t i = 0; i < n; i++) {
+                    store_block(out + (i * DES_BLOCK_BYTES), batch[i]);
+                }
+                break;
+
+            case DES_MODE_CTR:
+                /* Counter blocks are independent, so the keystream is produced in batches. */
+                for (size_t i = 0; i < n; i++) {
+                    batch[i] = stream.iv++;
+                }
+                des_encrypt_blocks(batch, batch, n, key_context);
+                for (size_t i = 0; i < n; i++) {
+                    store_block(out + (i * DES_BLOCK_BYTES), load_block(in + (i * DES_BLOCK_BYTES)) ^ batch[i]);
+                }
+                break;
+
+            case DES_MODE_CBC:
+                for (size_t i = 0; i < n; i++) {
+                    stream.iv = cipher_encrypt_block(key_context, load_block(in + (i * DES_BLOCK_BYTES)) ^ stream.iv);
+                    store_block(out + (i * DES_BLOCK_BYTES), stream.iv);
+                }
+                break;
+
+            case DES_MODE_CFB:
+                for (size_t i = 0; i < n; i++) {
+                    stream.iv = cipher_encrypt_block(key_context, stream.iv) ^ load_block(in + (i * DES_BLOCK_BYTES));
+                    store_block(out + (i * DES_BLOCK_BYTES), stream.iv);
+                }
+                break;
+
+            case DES_MODE_OFB:
+                for (size_t i = 0; i < n; i++) {
+                    stream.iv = cipher_encrypt_block(key_context, stream.iv);
+                    store_block(out + (i * DES_BLOCK_BYTES), load_block(in + (i * DES_BLOCK_BYTES)) ^ stream.iv);
+                }
+                break;
+        }
+    }
+}
+
+template<typename key_t>
+static void des_stream_decrypt_blocks_serial(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    uint64_t batch[DES_MODE_BATCH_BLOCKS];
+
+    for (size_t done = 0; done < blocks; done += DES_MODE_BATCH_BLOCKS) {
+        size_t n = (blocks - done < DES_MODE_BATCH_BLOCKS) ? (blocks - done) : DES_MODE_BATCH_BLOCKS;
+        const uint8_t* in = input + (done * DES_BLOCK_BYTES);
+        uint8_t* out = output + (done * DES_BLOCK_BYTES);
+
+        for (size_t i = 0; i < n; i++) {
+            batch[i] = load_block(in + (i * DES_BLOCK_BYTES));
+        }
+
+        /* All ciphertext is known up front, so every block cipher call in ECB, CBC and CFB
+         * decryption is independent and goes through the batched engine. */
+        switch (stream.mode) {
+            case DES_MODE_ECB:
+                des_decrypt_blocks(batch, batch, n, key_context);
+                for (size_t i = 0; i < n; i++) {
+                    store_block(out + (i * DES_BLOCK_BYTES), batch[i]);
+                }
+                break;
+
+            case DES_MODE_CBC:
+                des_decrypt_blocks(batch, batch, n, key_context);
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t c = load_block(in + (i * DES_BLOCK_BYTES));
+                    store_block(out + (i * DES_BLOCK_BYTES), batch[i] ^ stream.iv);
+                    stream.iv = c;
+                }
+                break;
+
+            case DES_MODE_CFB:
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t c = batch[i];
+                    batch[i] = stream.iv;
+                    stream.iv = c;
+                }
+                des_encrypt_blocks(batch, batch, n, key_context);
+                for (size_t i = 0; i < n; i++) {
+                    store_block(out + (i * DES_BLOCK_BYTES), load_block(in + (i * DES_BLOCK_BYTES)) ^ batch[i]);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/* ECB and CTR encryption, and ECB, CBC and CFB decryption, have no dependency between blocks
+ * beyond a chaining value that is known up front, so large requests are cut into cache-sized
+ * chunks and spread over the thread pool. */
+template<typename key_t>
+static void des_stream_encrypt_blocks_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    size_t chunks = (blocks + DES_MODE_CHUNK_BLOCKS - 1) / DES_MODE_CHUNK_BLOCKS;
+
+    if ((stream.mode != DES_MODE_ECB && stream.mode != DES_MODE_CTR) || chunks < 2 || des_get_thread_count() < 2) {
+        des_stream_encrypt_blocks_serial(stream, key_context, input, output, blocks);
+        return;
+    }
+
+    des_default_thread_pool().parallel_for(chunks, [&](size_t chunk) {
+        size_t first = chunk * DES_MODE_CHUNK_BLOCKS;
+        size_t n = (blocks - first < DES_MODE_CHUNK_BLOCKS) ? (blocks - first) : DES_MODE_CHUNK_BLOCKS;
+        des_stream_t chunk_stream = { stream.mode, stream.iv + first };
+
+        des_stream_encrypt_blocks_serial(chunk_stream, key_context, input + (first * DES_BLOCK_BYTES), output + (first * DES_BLOCK_BYTES), n);
+    });
+
+    if (stream.mode == DES_MODE_CTR) {
+        stream.iv += blocks;
+    }
+}
+
+template<typename key_t>
+static void des_stream_decrypt_blocks_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks) {
+    size_t chunks = (blocks + DES_MODE_CHUNK_BLOCKS - 1) / DES_MODE_CHUNK_BLOCKS;
+
+    if (stream.mode == DES_MODE_OFB || stream.mode == DES_MODE_CTR) {
+        /* The keystream does not depend on the data: decryption is encryption. */
+        des_stream_encrypt_blocks_impl(stream, key_context, input, output, blocks);
+        return;
+    }
+    if (chunks < 2 || des_get_thread_count() < 2) {
+        des_stream_decrypt_blocks_serial(stream, key_context, input, output, blocks);
+        return;
+    }
+
+    /* Each chunk chains from the ciphertext block before it; read them all before any chunk
+     * runs in case output overwrites input. */
+    vector<uint64_t> chaining(chunks);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        chaining[chunk] = (chunk == 0) ? stream.iv : load_block(input + (((chunk * DES_MODE_CHUNK_BLOCKS) - 1) * DES_BLOCK_BYTES));
+    }
+    uint64_t last = load_block(input + ((blocks - 1) * DES_BLOCK_BYTES));
+
+    des_default_thread_pool().parallel_for(chunks, [&](size_t chunk) {
+        size_t first = chunk * DES_MODE_CHUNK_BLOCKS;
+        size_t n = (blocks - first < DES_MODE_CHUNK_BLOCKS) ? (blocks - first) : DES_MODE_CHUNK_BLOCKS;
+        des_stream_t chunk_stream = { stream.mode, chaining[chunk] };
+
+        des_stream_decrypt_blocks_serial(chunk_stream, key_context, input + (first * DES_BLOCK_BYTES), output + (first * DES_BLOCK_BYTES), n);
+    });
+
+    stream.iv = last;
+}
+
+template<typename key_t>
+static void des_stream_final_impl(des_stream_t& stream, const key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt) {
+    uint8_t in[DES_BLOCK_BYTES] = {0}, out[DES_BLOCK_BYTES];
+
+    /* Run one zero-extended block through the mode and keep only `length` bytes. CFB feeds
+     * back ciphertext, which would include the zero padding, so it is done by hand. */
+    memcpy(in, input, length);
+    if (stream.mode == DES_MODE_CFB) {
+        store_block(out, cipher_encrypt_block(key_context, stream.iv) ^ load_block(in));
+    }
+    else if (decrypt) {
+        des_stream_decrypt_blocks_impl(stream, key_context, in, out, 1);
+    }
+    else {
+        des_stream_encrypt_blocks_impl(stream, key_context, in, out, 1);
+    }
+    memcpy(output, out, length);
+}
+
+template<typename key_t>
+static size_t des_mode_encrypt_impl(const des_mode_t mode, const key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output) {
+    des_stream_t stream = { mode, iv };
+    size_t blocks = length / DES_BLOCK_BYTES, tail = length % DES_BLOCK_BYTES;
+
+    des_stream_encrypt_blocks_impl(stream, key_context, input, output, blocks);
+    input += blocks * DES_BLOCK_BYTES;
+    output += blocks * DES_BLOCK_BYTES;
+
+    if (des_mode_is_padded(mode)) {
+        /* PKCS#5: always add 1..8 bytes, each holding the number of bytes added. */
+        uint8_t last[DES_BLOCK_BYTES];
+        memcpy(last, input, tail);
+        memset(last + tail, DES_BLOCK_BYTES - tail, DES_BLOCK_BYTES - tail);
+        des_stream_encrypt_blocks_impl(stream, key_context, last, output, 1);
+        return (blocks + 1) * DES_BLOCK_BYTES;
+    }
+
+    if (tail != 0) {
+        des_stream_final_impl(stream, key_context, input, output, tail, false);
+    }
+    return length;
+}
+
+template<typename key_t>
+static bool des_mode_decrypt_impl(const des_mode_t mode, const key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length) {
+    des_stream_t stream = { mode, iv };
+    size_t blocks = length / DES_BLOCK_BYTES, tail = length % DES_BLOCK_BYTES;
+
+    if (des_mode_is_padded(mode)) {
+        if (length == 0 || tail != 0) {
+            return false;
+        }
+
+        des_stream_decrypt_blocks_impl(stream, key_context, input, output, blocks);
+
+        uint8_t padding = output[length - 1];
+        if (padding == 0 || padding > DES_BLOCK_BYTES) {
+            return false;
+        }
+        for (size_t i = length - padding; i < length; i++) {
+            if (output[i] != padding) {
+                return false;
+            }
+        }
+        output_length = length - padding;
+        return true;
+    }
+
+    des_stream_decrypt_blocks_impl(stream, key_context, input, output, blocks);
+    if (tail != 0) {
+        des_stream_final_impl(stream, key_context, input + (blocks * DES_BLOCK_BYTES), output + (blocks * DES_BLOCK_BYTES), tail, true);
+    }
+    output_length = length;
+    return true;
+}
+
+static void des_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context, bool decrypt) {
+    /* Every bitslice kernel, the scalar one included, beats the table engine once a few
+     * passes are filled; below that the transposes cost more than they save. */
+    if (count >= 4 * DES_BITSLICE_BLOCKS) {
+        if (decrypt) {
+            des_bitslice_decrypt_blocks(input, output, count, key_context);
+        }
+        else {
+            des_bitslice_encrypt_blocks(input, output, count, key_context);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        output[i] = decrypt ? des_fast_decrypt_block(input[i], key_context) : des_fast_encrypt_block(input[i], key_context);
+    }
+}
+
+static void des_process_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context, bool decrypt) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = decrypt ? des3_fast_decrypt_block(input[i], key_context) : des3_fast_encrypt_block(input[i], key_context);
+    }
+}
+
+/* Independent blocks, so large requests are cut into chunks for the thread pool exactly like
+ * ECB in des_stream_encrypt_blocks_impl. */
+template<typename key_t>
+static void des_process_blocks_threaded(const uint64_t* input, uint64_t* output, size_t count, const key_t& key_context, bool decrypt) {
+    size_t chunks = (count + DES_MODE_CHUNK_BLOCKS - 1) / DES_MODE_CHUNK_BLOCKS;
+
+    if (chunks < 2 || des_get_thread_count() < 2) {
+        des_process_blocks(input, output, count, key_context, decrypt);
+        return;
+    }
+
+    des_default_thread_pool().parallel_for(chunks, [&](size_t chunk) {
+        size_t first = chunk * DES_MODE_CHUNK_BLOCKS;
+        size_t n = (count - first < DES_MODE_CHUNK_BLOCKS) ? (count - first) : DES_MODE_CHUNK_BLOCKS;
+
+        des_process_blocks(input + first, output + first, n, key_context, decrypt);
+    });
+}
+
+static void des_multi_key_process(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache* cache, bool decrypt) {
+    size_t blocks = key_count * blocks_per_key;
+    size_t chunks = (blocks + DES_MODE_CHUNK_BLOCKS - 1) / DES_MODE_CHUNK_BLOCKS;
+
+    if (chunks < 2 || des_get_thread_count() < 2) {
+        des_multi_key_process_serial(keys, 0, blocks, input, blocks_per_key, output, cache, decrypt);
+        return;
+    }
+
+    des_default_thread_pool().parallel_for(chunks, [&](size_t chunk) {
+        size_t first = chunk * DES_MODE_CHUNK_BLOCKS;
+        size_t n = (blocks - first < DES_MODE_CHUNK_BLOCKS) ? (blocks - first) : DES_MODE_CHUNK_BLOCKS;
+
+        des_multi_key_process_serial(keys, first, n, input, blocks_per_key, output, cache, decrypt);
+    });
+}
+
+/* Blocks [first_block, first_block + count) of a multi-key request; block i belongs to key
+ * i / blocks_per_key. */
+static void des_multi_key_process_serial(const uint64_t* keys, size_t first_block, size_t count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache* cache, bool decrypt) {
+    des_fast_key_t key_context;
+
+    if (cache != nullptr) {
+        /* Equal neighbouring keys (also across key slots) share one lookup and one bulk call. */
+        for (size_t block = first_block, end = first_block + count, run; block < end; block = run) {
+            uint64_t key = keys[block / blocks_per_key];
+
+            for (run = block + 1; run < end && keys[run / blocks_per_key] == key; run++) {
+            }
+            cache->get(key, key_context);
+            des_process_blocks(input + block, output + block, run - block, key_context, decrypt);
+        }
+        return;
+    }
+
+    if (count >= 4 * DES_BITSLICE_BLOCKS) {
+        /* Give every block its own key and let the bitslice kernel expand them all at once. */
+        uint64_t batch_keys[DES_MODE_BATCH_BLOCKS];
+
+        for (size_t done = 0; done < count; done += DES_MODE_BATCH_BLOCKS) {
+            size_t n = (count - done < DES_MODE_BATCH_BLOCKS) ? (count - done) : DES_MODE_BATCH_BLOCKS;
+            size_t block = first_block + done;
+
+            for (size_t i = 0; i < n; i++) {
+                batch_keys[i] = keys[(block + i) / blocks_per_key];
+            }
+            if (decrypt) {
+                des_bitslice_decrypt_keyed_blocks(batch_keys, input + block, output + block, n);
+            }
+            else {
+                des_bitslice_encrypt_keyed_blocks(batch_keys, input + block, output + block, n);
+            }
+        }
+        return;
+    }
+
+    size_t current = SIZE_MAX;
+
+    for (size_t block = first_block; block < first_block + count; block++) {
+        if (block / blocks_per_key != current) {
+            current = block / blocks_per_key;
+            des_fast_key_setup(key_context, keys[current]);
+        }
+        output[block] = decrypt ? des_fast_decrypt_block(input[block], key_context) : des_fast_encrypt_block(input[block], key_context);
+    }
+}
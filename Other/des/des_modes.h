@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * \file       des_modes.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the des modes of operation
+ * \details    ECB, CBC, CFB (64-bit feedback), OFB and CTR over byte buffers. ECB and CBC
+ *             use PKCS#5 padding; CFB, OFB and CTR are stream modes and handle a partial
+ *             final block. Blocks are read big-endian, so bit 1 of a block is the MSB of
+ *             its first byte. Every function is provided for single DES and triple DES keys.
+ ******************************************************************************
+*/
+#ifndef DES_MODES_H
+#define	DES_MODES_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_fast.h"
+#include "des_key_cache.h"
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_BLOCK_BYTES     8
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef enum {
+    DES_MODE_ECB,
+    DES_MODE_CBC,
+    DES_MODE_CFB,
+    DES_MODE_OFB,
+    DES_MODE_CTR
+} des_mode_t;
+
+/* Chaining state carried from one call to the next: the IV / previous ciphertext block for
+ * CBC and CFB, the last keystream block for OFB and the next counter block for CTR. */
+typedef struct {
+    des_mode_t mode;
+    uint64_t iv;
+} des_stream_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+inline uint64_t load_block(const uint8_t* bytes) {
+    uint64_t block = 0;
+    for (uint8_t i = 0; i < DES_BLOCK_BYTES; i++) {
+        block = (block << 8) | bytes[i];
+    }
+    return block;
+}
+
+inline void store_block(uint8_t* bytes, uint64_t block) {
+    for (int8_t i = DES_BLOCK_BYTES - 1; i >= 0; i--) {
+        bytes[i] = static_cast<uint8_t>(block);
+        block >>= 8;
+    }
+}
+
+bool des_mode_from_string(const string& name, des_mode_t& mode);
+bool des_mode_is_padded(const des_mode_t mode);
+
+/* Encrypt or decrypt many independent blocks with one key, batched through the widest engine.
+ * Requests of two or more chunks are spread over the thread pool (see des_set_thread_count). */
+void des_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context);
+void des_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des_fast_key_t& key_context);
+void des_encrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context);
+void des_decrypt_blocks(const uint64_t* input, uint64_t* output, size_t count, const des3_fast_key_t& key_context);
+
+/* Key agility: many keys with a few blocks each. Key k runs over input[k * blocks_per_key]
+ * up to input[(k + 1) * blocks_per_key - 1]; keys are raw 64-bit DES keys. With a vector
+ * bitslice kernel the keys are expanded together, so there is no per-key setup cost. */
+void des_multi_key_encrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output);
+void des_multi_key_decrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output);
+
+/* As above, for traffic that keeps coming back to the same keys: schedules are taken from
+ * cache, one lookup per run of consecutive blocks under the same key. */
+void des_multi_key_encrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache& cache);
+void des_multi_key_decrypt(const uint64_t* keys, size_t key_count, const uint64_t* input, size_t blocks_per_key, uint64_t* output, des_key_cache& cache);
+
+/* Whole blocks only; the stream state is advanced so calls can be chained over a long input. */
+void des_stream_encrypt_blocks(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+void des_stream_encrypt_blocks(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+void des_stream_decrypt_blocks(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+void des_stream_decrypt_blocks(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t blocks);
+
+/* Final partial block (fewer than 8 bytes) of a stream mode: XOR with one more keystream block. */
+void des_stream_final(des_stream_t& stream, const des_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt);
+void des_stream_final(des_stream_t& stream, const des3_fast_key_t& key_context, const uint8_t* input, uint8_t* output, size_t length, bool decrypt);
+
+/* One-shot helpers over arbitrary lengths. Encryption needs room for length + 8 bytes and
+ * returns the output length; decryption returns false on a wrong length or bad padding. */
+size_t des_mode_encrypt(const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output);
+size_t des_mode_encrypt(const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output);
+bool des_mode_decrypt(const des_mode_t mode, const des_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length);
+bool des_mode_decrypt(const des_mode_t mode, const des3_fast_key_t& key_context, const uint64_t iv, const uint8_t* input, size_t length, uint8_t* output, size_t& output_length);
+
+#endif	/* DES_MODES_H */
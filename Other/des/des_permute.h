@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * \file       des_permute.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the compile-time bit permutation compiler
+ * \details    A permutation table (output bit i + 1 is input bit table[i], bit 1 being the
+ *             MSB) is compiled by the compiler into a straight-line program on a 64-bit word:
+ *             one masked shift per distinct distance an input bit travels, or, when built
+ *             for BMI2 (e.g. -march=native), one PEXT/PDEP pair per run of output bits whose
+ *             inputs keep their relative order. Tables may repeat or drop input bits, so E,
+ *             PC-1 and PC-2 compile the same way as IP, IP-1 and P.
+ ******************************************************************************
+*/
+#ifndef DES_PERMUTE_H
+#define	DES_PERMUTE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define DES_PERMUTE_BMI2
+#endif
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* Step i of the shift program moves the input bits in shift_masks[i] by shifts[i] places
+ * (left when positive); step i of the chain program gathers the input bits in
+ * extract_masks[i] and scatters them, in order, to deposit_masks[i]. Bits are counted from
+ * the LSB here. */
+typedef struct {
+    uint8_t shift_count;
+    uint64_t shift_masks[64];
+    int8_t shifts[64];
+    uint8_t chain_count;
+    uint64_t extract_masks[64];
+    uint64_t deposit_masks[64];
+} permute_program_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+constexpr permute_program_t permute_compile(const uint8_t input_size, const uint8_t* table, const uint8_t output_size) {
+    permute_program_t program = {};
+    int8_t last_source[64] = {};
+
+    /* Output bits sharing a distance are moved by one shift. */
+    for (uint8_t i = 0; i < output_size; i++) {
+        int8_t target = static_cast<int8_t>(output_size - 1 - i), source = static_cast<int8_t>(input_size - table[i]);
+        int8_t shift = static_cast<int8_t>(target - source);
+        uint8_t step = 0;
+
+        while (step < program.shift_count && program.shifts[step] != shift) {
+            step++;
+        }
+        if (step == program.shift_count) {
+            program.shifts[program.shift_count++] = shift;
+        }
+        program.shift_masks[step] |= 1ULL << source;
+    }
+
+    /* Walking the outputs from the LSB, each bit joins the first chain whose last input lies
+     * below its own, so PEXT/PDEP keep the order; first fit needs the fewest chains. */
+    for (uint8_t target = 0; target < output_size; target++) {
+        int8_t source = static_cast<int8_t>(input_size - table[output_size - 1 - target]);
+        uint8_t chain = 0;
+
+        while (chain < program.chain_count && last_source[chain] >= source) {
+            chain++;
+        }
+        if (chain == program.chain_count) {
+            program.chain_count++;
+        }
+        program.extract_masks[chain] |= 1ULL << source;
+        program.deposit_masks[chain] |= 1ULL << target;
+        last_source[chain] = source;
+    }
+    return program;
+}
+
+template<uint64_t mask, int8_t shift>
+inline uint64_t permute_shift_step(const uint64_t input) {
+    if constexpr (shift >= 0) {
+        return (input & mask) << shift;
+    }
+    else {
+        return (input & mask) >> -shift;
+    }
+}
+
+template<const permute_program_t& program, size_t... step>
+inline uint64_t permute_run(const uint64_t input, std::index_sequence<step...>) {
+#ifdef DES_PERMUTE_BMI2
+    return (0 | ... | _pdep_u64(_pext_u64(input, program.extract_masks[step]), program.deposit_masks[step]));
+#else
+    return (0 | ... | permute_shift_step<program.shift_masks[step], program.shifts[step]>(input));
+#endif
+}
+
+/* The program of each table is built once, at compile time. */
+template<uint8_t input_size, uint8_t output_size, const uint8_t (&table)[output_size]>
+inline constexpr permute_program_t permute_program = permute_compile(input_size, table, output_size);
+
+/* Apply a permutation to the low input_size bits of input. */
+template<uint8_t input_size, uint8_t output_size, const uint8_t (&table)[output_size]>
+inline uint64_t permute_word(const uint64_t input) {
+#ifdef DES_PERMUTE_BMI2
+    const size_t steps = permute_program<input_size, output_size, table>.chain_count;
+#else
+    const size_t steps = permute_program<input_size, output_size, table>.shift_count;
+#endif
+    return permute_run<permute_program<input_size, output_size, table>>(input, std::make_index_sequence<steps>());
+}
+
+#endif	/* DES_PERMUTE_H */
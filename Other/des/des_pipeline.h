@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * \file       des_pipeline.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the bounded lock-free ring used between pipeline stages
+ * \details    Each ring has exactly one producer and one consumer thread. Slots hold pointers
+ *             to preallocated batches, so batches circulate reader -> cipher -> writer ->
+ *             reader without any allocation or locking.
+ ******************************************************************************
+*/
+#ifndef DES_PIPELINE_H
+#define	DES_PIPELINE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+/* Data Type Declarations ---------------------------------------------------*/
+template<typename value_t, size_t capacity>
+class des_spsc_ring {
+public:
+    des_spsc_ring() : head(0), tail(0) {}
+
+    bool try_push(const value_t& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == capacity) {
+            return false;
+        }
+        slots[t % capacity] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool try_pop(value_t& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) {
+            return false;
+        }
+        value = slots[h % capacity];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    /* Blocking variants: spin briefly, then yield, then sleep so an idle stage (e.g. waiting
+     * on a slow pipe) does not burn a core. */
+    void push(const value_t& value) {
+        for (uint32_t spins = 0; !try_push(value); spins++) {
+            backoff(spins);
+        }
+    }
+
+    value_t pop() {
+        value_t value;
+        for (uint32_t spins = 0; !try_pop(value); spins++) {
+            backoff(spins);
+        }
+        return value;
+    }
+
+private:
+    value_t slots[capacity];
+    /* Producer and consumer indices on separate cache lines. */
+    alignas(64) atomic<size_t> head;
+    alignas(64) atomic<size_t> tail;
+
+    static void backoff(uint32_t spins) {
+        if (spins < 64) {
+            return;
+        }
+        if (spins < 256) {
+            this_thread::yield();
+            return;
+        }
+        this_thread::sleep_for(chrono::microseconds(50));
+    }
+};
+
+#endif	/* DES_PIPELINE_H */
@@ -0,0 +1,252 @@
+/**
+ ******************************************************************************
+ * \file       des_search.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the known-plaintext key search
+ ******************************************************************************
+*/
+#include "des_search.h"
+#include "des_thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+/* Macro Declarations -------------------------------------------------------*/
+#define DES_SEARCH_CANDIDATES   64
+
+/* Static Functions Declarations --------------------------------------------*/
+static bool search_setup(const des_search_config_t& config, des_bitslice_search_t& search, uint64_t& index_count, string& error);
+static uint64_t index_to_key(const des_bitslice_search_t& search, const uint64_t index);
+static string checkpoint_parameters(const des_search_config_t& config, const des_search_result_t& result);
+static bool load_checkpoint(const des_search_config_t& config, des_search_result_t& result, string& error);
+static bool save_checkpoint(const des_search_config_t& config, const des_search_result_t& result, string& error);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_key_search(const des_search_config_t& config, des_search_result_t& result, const function<void(const des_search_result_t&)>& progress, string& error) {
+    des_bitslice_search_t search;
+    uint64_t index_count;
+
+    if (!search_setup(config, search, index_count, error)) {
+        return false;
+    }
+
+    result = {};
+    result.start = config.start;
+    result.end = (config.end == 0 || config.end > index_count) ? index_count : config.end;
+    result.next_index = result.start;
+    if (result.start >= result.end) {
+        error = "empty key range";
+        return false;
+    }
+    if (!config.checkpoint_path.empty() && !load_checkpoint(config, result, error)) {
+        return false;
+    }
+
+    des_thread_pool& pool = des_default_thread_pool();
+    uint64_t epoch_keys = DES_SEARCH_CHUNK_KEYS * DES_SEARCH_EPOCH_CHUNKS * pool.size();
+    uint64_t keys_per_index = config.use_complement ? 2 : 1;
+    atomic<bool> found(result.found);
+    mutex found_lock;
+
+    while (!found.load() && result.next_index < result.end) {
+        auto begin = chrono::steady_clock::now();
+        uint64_t epoch_start = result.next_index;
+        uint64_t epoch_end = (result.end - epoch_start < epoch_keys) ? result.end : (epoch_start + epoch_keys);
+        size_t chunks = static_cast<size_t>((epoch_end - epoch_start + DES_SEARCH_CHUNK_KEYS - 1) / DES_SEARCH_CHUNK_KEYS);
+
+        pool.parallel_for(chunks, [&](size_t chunk) {
+            des_bitslice_candidate_t candidates[DES_SEARCH_CANDIDATES];
+            uint64_t first = epoch_start + (chunk * DES_SEARCH_CHUNK_KEYS);
+            uint64_t count = (epoch_end - first < DES_SEARCH_CHUNK_KEYS) ? (epoch_end - first) : DES_SEARCH_CHUNK_KEYS;
+
+            if (found.load(memory_order_relaxed)) {
+                return;
+            }
+
+            /* Only R15 was compared, so confirm every candidate with a full encryption. A
+             * candidate for the complement target stands for the complemented key. When the
+             * buffer fills up, the kernel is called again from where it stopped. */
+            for (uint64_t next = first, end = first + count; next < end;) {
+                size_t n = des_bitslice_search_keys(search, next, end - next, candidates, DES_SEARCH_CANDIDATES, next);
+
+                for (size_t i = 0; i < n; i++) {
+                    des_fast_key_t key_context;
+                    uint64_t key = index_to_key(search, candidates[i].index);
+
+                    if (candidates[i].target == 1) {
+                        key = ~key;
+                    }
+                    des_fast_key_setup(key_context, key);
+                    if (des_fast_encrypt_block(config.plaintext, key_context) != config.ciphertext) {
+                        continue;
+                    }
+                    if (config.use_complement && des_fast_encrypt_block(~config.plaintext, key_context) != config.complement_ciphertext) {
+                        continue;
+                    }
+
+                    lock_guard<mutex> guard(found_lock);
+                    if (!found.load()) {
+                        result.key = des_key_with_parity(key);
+                        found.store(true);
+                    }
+                }
+            }
+        });
+
+        result.found = found.load();
+        result.next_index = epoch_end;
+        result.keys_tested += (epoch_end - epoch_start) * keys_per_index;
+        result.seconds += chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        if (!config.checkpoint_path.empty() && !save_checkpoint(config, result, error)) {
+            return false;
+        }
+        if (progress) {
+            progress(result);
+        }
+    }
+    return true;
+}
+
+uint64_t des_key_with_parity(const uint64_t key) {
+    uint64_t output = 0;
+
+    for (uint8_t byte = 0; byte < 8; byte++) {
+        uint64_t value = (key >> (8 * byte)) & 0xFE;
+        value |= (__builtin_popcountll(value) & 1) ^ 1;
+        output |= value << (8 * byte);
+    }
+    return output;
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static bool search_setup(const des_search_config_t& config, des_bitslice_search_t& search, uint64_t& index_count, string& error) {
+    uint64_t mask = config.mask & DES_SEARCH_KEY_BITS;
+
+    search = {};
+    search.plaintext = config.plaintext;
+    search.targets[0] = config.ciphertext;
+    search.target_count = 1;
+    search.base_key = config.base_key & ~mask;
+
+    if (config.use_complement) {
+        if (mask != DES_SEARCH_KEY_BITS) {
+            error = "the complementation property needs all 56 key bits in the mask";
+            return false;
+        }
+
+        /* Keys with the top bit set are the complements of those without it. */
+        mask &= ~(1ULL << 63);
+        search.targets[1] = ~config.complement_ciphertext;
+        search.target_count = 2;
+    }
+
+    for (uint8_t bit = 0; bit < 64; bit++) {
+        if ((mask >> bit) & 1) {
+            search.bits[search.bit_count++] = bit;
+        }
+    }
+    if (search.bit_count == 0) {
+        error = "the mask selects no key bits";
+        return false;
+    }
+
+    index_count = (search.bit_count >= 64) ? ~0ULL : (1ULL << search.bit_count);
+    return true;
+}
+
+static uint64_t index_to_key(const des_bitslice_search_t& search, const uint64_t index) {
+    uint64_t key = search.base_key;
+
+    for (uint8_t s = 0; s < search.bit_count; s++) {
+        key |= ((index >> s) & 1) << search.bits[s];
+    }
+    return key;
+}
+
+/* The checkpoint is a list of `name value` lines; the search parameters are stored too so a
+ * file from a different search is refused instead of silently resumed. */
+static string checkpoint_parameters(const des_search_config_t& config, const des_search_result_t& result) {
+    ostringstream text;
+
+    text << hex << uppercase
+         << "plaintext " << config.plaintext << "\n"
+         << "ciphertext " << config.ciphertext << "\n"
+         << "complement " << (config.use_complement ? config.complement_ciphertext : 0) << " " << config.use_complement << "\n"
+         << "mask " << (config.mask & DES_SEARCH_KEY_BITS) << "\n"
+         << "base " << (config.base_key & ~config.mask & DES_SEARCH_KEY_BITS) << "\n"
+         << "range " << result.start << " " << result.end << "\n";
+    return text.str();
+}
+
+static bool load_checkpoint(const des_search_config_t& config, des_search_result_t& result, string& error) {
+    ifstream file(config.checkpoint_path);
+    string parameters, line;
+
+    if (!file) {
+        /* Nothing saved yet: a fresh run. */
+        return true;
+    }
+
+    for (uint8_t i = 0; i < 6 && getline(file, line); i++) {
+        parameters += line + "\n";
+    }
+    if (parameters != checkpoint_parameters(config, result)) {
+        error = "checkpoint " + config.checkpoint_path + " belongs to a different search";
+        return false;
+    }
+
+    while (getline(file, line)) {
+        istringstream fields(line);
+        string name;
+
+        fields >> name;
+        if (name == "next") {
+            fields >> hex >> result.next_index;
+        }
+        else if (name == "tested") {
+            fields >> hex >> result.keys_tested;
+        }
+        else if (name == "seconds") {
+            fields >> result.seconds;
+        }
+        else if (name == "found") {
+            fields >> hex >> result.key;
+            result.found = true;
+        }
+    }
+    if (result.next_index < result.start || result.next_index > result.end) {
+        error = "checkpoint " + config.checkpoint_path + " is corrupt";
+        return false;
+    }
+    return true;
+}
+
+static bool save_checkpoint(const des_search_config_t& config, const des_search_result_t& result, string& error) {
+    /* Write a new file and rename it over the old one, so a crash leaves one of the two. */
+    string temporary = config.checkpoint_path + ".tmp";
+    {
+        ofstream file(temporary, ios::trunc);
+
+        file << checkpoint_parameters(config, result)
+             << hex << uppercase
+             << "next " << result.next_index << "\n"
+             << "tested " << result.keys_tested << "\n"
+             << dec << "seconds " << result.seconds << "\n";
+        if (result.found) {
+            file << hex << "found " << result.key << "\n";
+        }
+        if (!file.flush()) {
+            error = "cannot write checkpoint " + temporary;
+            return false;
+        }
+    }
+    if (rename(temporary.c_str(), config.checkpoint_path.c_str()) != 0) {
+        error = "cannot replace checkpoint " + config.checkpoint_path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * \file       des_search.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the known-plaintext key search
+ * \details    The searched key bits are enumerated as a binary index. The index range is
+ *             cut into chunks that the thread pool spreads over the cores, and each chunk
+ *             runs through the bitsliced search kernel (one key per lane, early abort in
+ *             round 15). Progress is saved after every epoch of chunks so a run can resume.
+ ******************************************************************************
+*/
+#ifndef DES_SEARCH_H
+#define	DES_SEARCH_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_bitslice.h"
+#include <functional>
+
+/* Macro Declarations -------------------------------------------------------*/
+/* The 56 bits PC-1 reads; the low bit of every byte is parity. */
+#define DES_SEARCH_KEY_BITS     0xFEFEFEFEFEFEFEFEULL
+
+/* Key indices per thread pool task, and tasks per thread between two checkpoints. */
+#define DES_SEARCH_CHUNK_KEYS   (1ULL << 22)
+#define DES_SEARCH_EPOCH_CHUNKS 8
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* With use_complement, complement_ciphertext is the encryption of ~plaintext under the same
+ * key. Since E_~k(~p) = ~E_k(p), every key tried also tests its complement, so only half of
+ * the keys are run; this needs every key bit in the mask. end == 0 means the whole range. */
+typedef struct {
+    uint64_t plaintext;
+    uint64_t ciphertext;
+    bool use_complement;
+    uint64_t complement_ciphertext;
+    uint64_t mask;
+    uint64_t base_key;
+    uint64_t start;
+    uint64_t end;
+    string checkpoint_path;
+} des_search_config_t;
+
+/* keys_tested counts the complements checked along the way; the times add up over resumes. */
+typedef struct {
+    bool found;
+    uint64_t key;
+    uint64_t start;
+    uint64_t end;
+    uint64_t next_index;
+    uint64_t keys_tested;
+    double seconds;
+} des_search_result_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Search until a key is found or the range is exhausted; progress is called after every
+ * epoch. Resumes from config.checkpoint_path when it holds a run of the same search.
+ * Returns false and fills error when the configuration or the checkpoint is invalid. */
+bool des_key_search(const des_search_config_t& config, des_search_result_t& result, const function<void(const des_search_result_t&)>& progress, string& error);
+
+/* Set the low bit of every byte so each byte has odd parity, as DES keys are written. */
+uint64_t des_key_with_parity(const uint64_t key);
+
+#endif	/* DES_SEARCH_H */
@@ -0,0 +1,420 @@
+/**
+ ******************************************************************************
+ * \file       des_selftest.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the des self-test
+ ******************************************************************************
+*/
+#include "des_selftest.h"
+#include "des_fast.h"
+#include "des_bitslice.h"
+#include "des_modes.h"
+#include "des_thread_pool.h"
+#include "des_search.h"
+#include "des_codec.h"
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef struct {
+    uint64_t key;
+    uint64_t plaintext;
+    uint64_t ciphertext;
+} des_vector_t;
+
+/* Variables Definitions ----------------------------------------------------*/
+/* NIST SP 800-17 (variable plaintext / variable key) and the worked example used in des.cpp. */
+static const des_vector_t DES_VECTORS[] = {
+    { 0x133457799BBCDFF1ULL, 0x0123456789ABCDEFULL, 0x85E813540F0AB405ULL },
+    { 0x0101010101010101ULL, 0x8000000000000000ULL, 0x95F8A5E5DD31D900ULL },
+    { 0x0101010101010101ULL, 0x4000000000000000ULL, 0xDD7F121CA5015619ULL },
+    { 0x0101010101010101ULL, 0x2000000000000000ULL, 0x2E8653104F3834EAULL },
+    { 0x8001010101010101ULL, 0x0000000000000000ULL, 0x95A8D72813DAA94DULL },
+    { 0x4001010101010101ULL, 0x0000000000000000ULL, 0x0EEC1487DD8C26D5ULL },
+    { 0x0E329232EA6D0D73ULL, 0x8787878787878787ULL, 0x0000000000000000ULL }
+};
+
+/* FIPS 81 mode examples: key 0123456789ABCDEF, IV 1234567890ABCDEF, "Now is the time for all ". */
+static const uint8_t FIPS81_PLAINTEXT[] = "Now is the time for all ";
+static const uint64_t FIPS81_KEY = 0x0123456789ABCDEFULL;
+static const uint64_t FIPS81_IV = 0x1234567890ABCDEFULL;
+static const uint64_t FIPS81_CIPHERTEXT[][3] = {
+    { 0x3FA40E8A984D4815ULL, 0x6A271787AB8883F9ULL, 0x893D51EC4B563B53ULL },    /* ECB */
+    { 0xE5C7CDDE872BF27CULL, 0x43E934008C389C0FULL, 0x683788499A7C05F6ULL },    /* CBC */
+    { 0xF3096249C7F46E51ULL, 0xA69E839B1A92F784ULL, 0x03467133898EA622ULL },    /* CFB */
+    { 0xF3096249C7F46E51ULL, 0x35F24A242EEB3D3FULL, 0x3D6D5BE3255AF8C3ULL }     /* OFB */
+};
+
+/* NIST SP 800-67 TDEA example (three distinct keys, "The qufck brown fox jump"). */
+static const uint8_t TDEA_PLAINTEXT[] = "The qufck brown fox jump";
+static const uint64_t TDEA_KEYS[3] = { 0x0123456789ABCDEFULL, 0x23456789ABCDEF01ULL, 0x456789ABCDEF0123ULL };
+static const uint64_t TDEA_CIPHERTEXT[3] = { 0xA826FD8CE53B855FULL, 0xCCE21C8112256FE6ULL, 0x68D5C05DD9B6B900ULL };
+
+/* Static Functions Declarations --------------------------------------------*/
+static bool check(const string& name, bool passed, size_t& failures);
+static bool known_answer_tests(size_t& failures);
+static bool differential_tests(const size_t iterations, size_t& failures);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_self_test(const size_t iterations) {
+    size_t failures = 0;
+
+    known_answer_tests(failures);
+    differential_tests(iterations, failures);
+
+    if (failures == 0) {
+        cout << rang::fg::green << "All self-tests passed." << rang::style::reset << endl;
+    }
+    else {
+        cout << rang::fg::red << failures << " self-test(s) failed." << rang::style::reset << endl;
+    }
+    return failures == 0;
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static bool check(const string& name, bool passed, size_t& failures) {
+    cout << (passed ? rang::fg::green : rang::fg::red) << (passed ? "[PASS] " : "[FAIL] ") << rang::style::reset << name << endl;
+    if (!passed) {
+        failures++;
+    }
+    return passed;
+}
+
+static bool known_answer_tests(size_t& failures) {
+    size_t before = failures;
+
+    for (const des_vector_t& v : DES_VECTORS) {
+        des_key_t key_context;
+        des_fast_key_t fast_key_context;
+        uint64_t bitslice_output = 0, bitslice_input = v.ciphertext, bitslice_back = 0;
+        bool passed = true;
+
+        des_key_setup(key_context, bitset<64>(v.key));
+        des_fast_key_setup(fast_key_context, v.key);
+        des_bitslice_encrypt_blocks(&v.plaintext, &bitslice_output, 1, fast_key_context);
+        des_bitslice_decrypt_blocks(&bitslice_input, &bitslice_back, 1, fast_key_context);
+
+        passed = passed && des_encrypt_block(bitset<64>(v.plaintext), key_context).to_ullong() == v.ciphertext;
+        passed = passed && des_decrypt_block(bitset<64>(v.ciphertext), key_context).to_ullong() == v.plaintext;
+        passed = passed && des_fast_encrypt_block(v.plaintext, fast_key_context) == v.ciphertext;
+        passed = passed && des_fast_decrypt_block(v.ciphertext, fast_key_context) == v.plaintext;
+        passed = passed && bitslice_output == v.ciphertext && bitslice_back == v.plaintext;
+
+        ostringstream name;
+        name << "KAT DES key " << hex << uppercase << setfill('0') << setw(16) << v.key << " plaintext " << setw(16) << v.plaintext;
+        check(name.str(), passed, failures);
+    }
+
+    des_fast_key_t fips81_key;
+    des_fast_key_setup(fips81_key, FIPS81_KEY);
+    const des_mode_t fips81_modes[] = { DES_MODE_ECB, DES_MODE_CBC, DES_MODE_CFB, DES_MODE_OFB };
+    const char* fips81_names[] = { "ECB", "CBC", "CFB", "OFB" };
+    for (uint8_t m = 0; m < 4; m++) {
+        uint8_t output[24], back[24];
+        des_stream_t stream = { fips81_modes[m], FIPS81_IV };
+        bool passed = true;
+
+        des_stream_encrypt_blocks(stream, fips81_key, FIPS81_PLAINTEXT, output, 3);
+        for (uint8_t i = 0; i < 3; i++) {
+            passed = passed && load_block(output + (i * DES_BLOCK_BYTES)) == FIPS81_CIPHERTEXT[m][i];
+        }
+        stream = { fips81_modes[m], FIPS81_IV };
+        des_stream_decrypt_blocks(stream, fips81_key, output, back, 3);
+        passed = passed && memcmp(back, FIPS81_PLAINTEXT, 24) == 0;
+
+        check(string("KAT FIPS 81 ") + fips81_names[m], passed, failures);
+    }
+
+    des3_fast_key_t tdea_key;
+    uint8_t tdea_output[24], tdea_back[24];
+    des_stream_t tdea_stream = { DES_MODE_ECB, 0 };
+    bool tdea_passed = true;
+    des3_fast_key_setup(tdea_key, TDEA_KEYS[0], TDEA_KEYS[1], TDEA_KEYS[2]);
+    des_stream_encrypt_blocks(tdea_stream, tdea_key, TDEA_PLAINTEXT, tdea_output, 3);
+    for (uint8_t i = 0; i < 3; i++) {
+        tdea_passed = tdea_passed && load_block(tdea_output + (i * DES_BLOCK_BYTES)) == TDEA_CIPHERTEXT[i];
+    }
+    des_stream_decrypt_blocks(tdea_stream, tdea_key, tdea_output, tdea_back, 3);
+    tdea_passed = tdea_passed && memcmp(tdea_back, TDEA_PLAINTEXT, 24) == 0;
+    check("KAT SP 800-67 TDEA EDE3", tdea_passed, failures);
+
+    /* RFC 4648 base64 of the bytes 01 23 45 67 89 AB CD EF. */
+    char hex_text[DES_HEX_BLOCK_CHARS], base64_text[DES_BASE64_BLOCK_CHARS];
+    uint64_t hex_block, base64_block;
+    des_hex_encode_block(0x0123456789ABCDEFULL, hex_text);
+    des_base64_encode_block(0x0123456789ABCDEFULL, base64_text);
+    bool codec_passed = memcmp(hex_text, "0123456789ABCDEF", DES_HEX_BLOCK_CHARS) == 0
+                        && memcmp(base64_text, "ASNFZ4mrze8=", DES_BASE64_BLOCK_CHARS) == 0
+                        && des_hex_decode_block("0123456789abcdef", hex_block) && hex_block == 0x0123456789ABCDEFULL
+                        && des_base64_decode_block("ASNFZ4mrze8=", base64_block) && base64_block == 0x0123456789ABCDEFULL
+                        && !des_hex_decode_block("0123456789ABCDEG", hex_block)
+                        && !des_base64_decode_block("ASNFZ4mrze9=", base64_block);
+    check("KAT hex and base64 block codecs", codec_passed, failures);
+
+    return failures == before;
+}
+
+static bool differential_tests(const size_t iterations, size_t& failures) {
+    mt19937_64 random(0xDE5DE5DE5ULL);
+    size_t before = failures;
+    bool fast_ok = true, decrypt_ok = true, tdes_ok = true, ct_ok = true;
+
+    /* Every engine against the bitset reference, block by block. */
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t key = random(), keys[3] = { random(), random(), random() }, block = random();
+        des_key_t key_context;
+        des_fast_key_t fast_key_context, ct_key_context, single[3];
+        des3_fast_key_t key3_context;
+
+        des_key_setup(key_context, bitset<64>(key));
+        des_fast_key_setup(fast_key_context, key);
+        uint64_t reference = des_encrypt_block(bitset<64>(block), key_context).to_ullong();
+
+        fast_ok = fast_ok && des_fast_encrypt_block(block, fast_key_context) == reference;
+        decrypt_ok = decrypt_ok && des_fast_decrypt_block(reference, fast_key_context) == block
+                     && des_decrypt_block(bitset<64>(reference), key_context).to_ullong() == block;
+
+        /* The constant-time schedule must build the very same key context. */
+        des_fast_key_setup_ct(ct_key_context, key);
+        ct_ok = ct_ok && memcmp(&ct_key_context, &fast_key_context, sizeof(des_fast_key_t)) == 0;
+
+        /* 3DES with the elided inner permutations against three separate DES calls. */
+        des3_fast_key_setup(key3_context, keys[0], keys[1], keys[2]);
+        for (uint8_t k = 0; k < 3; k++) {
+            des_fast_key_setup(single[k], keys[k]);
+        }
+        uint64_t composed = des_fast_encrypt_block(des_fast_decrypt_block(des_fast_encrypt_block(block, single[0]), single[1]), single[2]);
+        tdes_ok = tdes_ok && des3_fast_encrypt_block(block, key3_context) == composed
+                  && des3_fast_decrypt_block(composed, key3_context) == block;
+    }
+    check("Differential fast engine vs reference", fast_ok, failures);
+    check("Differential decryption round trip", decrypt_ok, failures);
+    check("Differential constant-time key setup vs fast", ct_ok, failures);
+    check("Differential 3DES vs composed DES", tdes_ok, failures);
+
+    /* The compiled permutation programs against the plain table walk. */
+    bool permute_ok = true;
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t block = random();
+
+        permute_ok = permute_ok
+                     && permute_word<64, 64, IP>(block) == permute_bits(block, 64, IP, 64)
+                     && permute_word<64, 64, IP_INV>(block) == permute_bits(block, 64, IP_INV, 64)
+                     && permute_word<64, 56, PC1>(block) == permute_bits(block, 64, PC1, 56)
+                     && permute_word<56, 48, PC2>(block >> 8) == permute_bits(block >> 8, 56, PC2, 48)
+                     && permute_word<32, 48, E>(block >> 32) == permute_bits(block >> 32, 32, E, 48)
+                     && permute_word<32, 32, P>(block >> 32) == permute_bits(block >> 32, 32, P, 32);
+    }
+    check("Differential compiled permutations vs table walk", permute_ok, failures);
+
+    bool codec_ok = true;
+    for (size_t i = 0; i < iterations; i++) {
+        char hex_text[DES_HEX_BLOCK_CHARS], base64_text[DES_BASE64_BLOCK_CHARS];
+        uint64_t block = random(), hex_block, base64_block;
+
+        des_hex_encode_block(block, hex_text);
+        des_base64_encode_block(block, base64_text);
+        codec_ok = codec_ok && des_hex_decode_block(hex_text, hex_block) && hex_block == block
+                   && des_base64_decode_block(base64_text, base64_block) && base64_block == block;
+    }
+    check("Differential hex and base64 codec round trip", codec_ok, failures);
+
+    /* Cached schedules against fresh ones on a small key pool, so keys hit, miss and get
+     * evicted; then the eviction order on a single shard: touching a key keeps it alive. */
+    des_key_cache cache(64);
+    vector<uint64_t> pool(100), keys(iterations), cached_output(iterations), plain_output(iterations), blocks(iterations);
+    bool cache_ok = true;
+    for (uint64_t& key : pool) {
+        key = random();
+    }
+    for (size_t i = 0; i < iterations; i++) {
+        des_fast_key_t cached_key_context, fast_key_context;
+
+        keys[i] = pool[random() % (1 + (i % pool.size()))];
+        blocks[i] = random();
+        cache.get(keys[i], cached_key_context);
+        des_fast_key_setup(fast_key_context, keys[i]);
+        cache_ok = cache_ok && memcmp(&cached_key_context, &fast_key_context, sizeof(des_fast_key_t)) == 0;
+    }
+    des_multi_key_encrypt(keys.data(), iterations, blocks.data(), 1, cached_output.data(), cache);
+    des_multi_key_encrypt(keys.data(), iterations, blocks.data(), 1, plain_output.data());
+    cache_ok = cache_ok && cached_output == plain_output && cache.size() <= cache.capacity()
+               && cache.hits() + cache.misses() >= iterations;
+
+    des_key_cache lru_cache(8, 1);
+    des_fast_key_t lru_key_context;
+    for (uint64_t key = 0; key <= 8; key++) {
+        lru_cache.get(key, lru_key_context);
+        lru_cache.get(0, lru_key_context);
+    }
+    lru_cache.get(1, lru_key_context);
+    cache_ok = cache_ok && lru_cache.hits() == 9 && lru_cache.misses() == 10 && lru_cache.size() == 8;
+    check("Differential key cache vs fresh setup, LRU eviction", cache_ok, failures);
+
+    /* Bitslice kernels on batches of awkward sizes against the fast engine. */
+    des_bitslice_kernel_t selected = des_bitslice_get_kernel();
+    for (des_bitslice_kernel_t kernel : { DES_BITSLICE_KERNEL_SCALAR, DES_BITSLICE_KERNEL_AVX2, DES_BITSLICE_KERNEL_AVX512 }) {
+        if (!des_bitslice_set_kernel(kernel)) {
+            continue;
+        }
+
+        bool passed = true;
+        for (size_t i = 0; i < 8; i++) {
+            size_t count = 1 + (random() % 1500);
+            vector<uint64_t> input(count), output(count), back(count);
+            des_fast_key_t fast_key_context;
+
+            des_fast_key_setup(fast_key_context, random());
+            for (uint64_t& block : input) {
+                block = random();
+            }
+            des_bitslice_encrypt_blocks(input.data(), output.data(), count, fast_key_context);
+            des_bitslice_decrypt_blocks(output.data(), back.data(), count, fast_key_context);
+            for (size_t j = 0; j < count; j++) {
+                passed = passed && output[j] == des_fast_encrypt_block(input[j], fast_key_context) && back[j] == input[j];
+            }
+        }
+        check(string("Differential bitslice ") + des_bitslice_kernel_name(kernel) + " vs fast engine", passed, failures);
+
+        /* Multi-key batches: a random key per block through the bitslice key schedule, and a
+         * few blocks per key through the mode-level API, which splits them across kernels. */
+        bool keyed_ok = true;
+        for (size_t i = 0; i < 8; i++) {
+            size_t key_count = 1 + (random() % 700), blocks_per_key = 1 + (i % 3), count = key_count * blocks_per_key;
+            vector<uint64_t> keys(key_count), input(count), output(count), back(count), keyed_output(key_count);
+            des_fast_key_t fast_key_context;
+
+            for (uint64_t& key : keys) {
+                key = random();
+            }
+            for (uint64_t& block : input) {
+                block = random();
+            }
+            des_bitslice_encrypt_keyed_blocks(keys.data(), input.data(), keyed_output.data(), key_count);
+            des_multi_key_encrypt(keys.data(), key_count, input.data(), blocks_per_key, output.data());
+            des_multi_key_decrypt(keys.data(), key_count, output.data(), blocks_per_key, back.data());
+            for (size_t k = 0; k < key_count; k++) {
+                des_fast_key_setup(fast_key_context, keys[k]);
+                keyed_ok = keyed_ok && keyed_output[k] == des_fast_encrypt_block(input[k], fast_key_context);
+                for (size_t j = k * blocks_per_key; j < (k + 1) * blocks_per_key; j++) {
+                    keyed_ok = keyed_ok && output[j] == des_fast_encrypt_block(input[j], fast_key_context) && back[j] == input[j];
+                }
+            }
+        }
+        check(string("Differential multi-key ") + des_bitslice_kernel_name(kernel) + " vs fast engine", keyed_ok, failures);
+
+        /* The key search must recover a random key from 2^16 candidates, directly and through
+         * the complementation property. */
+        bool search_ok = true;
+        for (uint8_t complement = 0; complement < 2; complement++) {
+            des_search_config_t config = {};
+            des_search_result_t result;
+            des_fast_key_t fast_key_context;
+            uint64_t key = random() | (1ULL << 63), index = 0;
+            string error;
+
+            des_fast_key_setup(fast_key_context, key);
+            config.plaintext = random();
+            config.ciphertext = des_fast_encrypt_block(config.plaintext, fast_key_context);
+            config.mask = DES_SEARCH_KEY_BITS;
+            config.base_key = key;
+            if (complement) {
+                config.use_complement = true;
+                config.complement_ciphertext = des_fast_encrypt_block(~config.plaintext, fast_key_context);
+            }
+
+            /* Key indices enumerate the key bits from the least significant one; the top bit is
+             * left out with the complement, and the key with it set is found as ~key. */
+            uint64_t indexed = complement ? ~key : key;
+            for (uint8_t bit = 0, s = 0; bit < (complement ? 63 : 64); bit++) {
+                if ((DES_SEARCH_KEY_BITS >> bit) & 1) {
+                    index |= ((indexed >> bit) & 1) << s++;
+                }
+            }
+            config.start = index - (index % 65536);
+            config.end = config.start + 65536;
+
+            search_ok = search_ok && des_key_search(config, result, nullptr, error) && result.found
+                        && (result.key & DES_SEARCH_KEY_BITS) == (key & DES_SEARCH_KEY_BITS);
+        }
+        check(string("Key search ") + des_bitslice_kernel_name(kernel) + " recovers random keys", search_ok, failures);
+
+        /* With the eight parity bits searched, 256 equivalent keys in 1024 indices match, far
+         * more than one buffer holds; every one must come back, once and in order. */
+        des_bitslice_search_t search = {};
+        des_bitslice_candidate_t candidates[64];
+        des_fast_key_t parity_key_context;
+        uint64_t parity_key = random(), last_index = 0;
+        size_t candidate_count = 0;
+        bool overflow_ok = true;
+
+        des_fast_key_setup(parity_key_context, parity_key);
+        search.plaintext = random();
+        search.targets[0] = des_fast_encrypt_block(search.plaintext, parity_key_context);
+        search.target_count = 1;
+        for (uint8_t bit = 0; bit < 64; bit += 8) {
+            search.bits[search.bit_count++] = bit;
+        }
+        search.bits[search.bit_count++] = 1;
+        search.bits[search.bit_count++] = 9;
+        search.base_key = parity_key & ~(0x0101010101010101ULL | 0x0202ULL);
+        for (uint64_t next = 0; next < 1024;) {
+            size_t n = des_bitslice_search_keys(search, next, 1024 - next, candidates, 64, next);
+            for (size_t i = 0; i < n; i++) {
+                overflow_ok = overflow_ok && (candidate_count == 0 || candidates[i].index > last_index)
+                              && ((candidates[i].index >> 8) & 1) == ((parity_key >> 1) & 1)
+                              && ((candidates[i].index >> 9) & 1) == ((parity_key >> 9) & 1);
+                last_index = candidates[i].index;
+                candidate_count++;
+            }
+        }
+        check(string("Key search ") + des_bitslice_kernel_name(kernel) + " keeps candidates past a full buffer", overflow_ok && candidate_count == 256, failures);
+    }
+    des_bitslice_set_kernel(selected);
+
+    /* Modes: one-shot serial result against chunked and multi-threaded processing. */
+    size_t threads = des_get_thread_count();
+    for (uint8_t m = DES_MODE_ECB; m <= DES_MODE_CTR; m++) {
+        des_mode_t mode = static_cast<des_mode_t>(m);
+        des_fast_key_t fast_key_context;
+        size_t length = (20000 * DES_BLOCK_BYTES) + (random() % DES_BLOCK_BYTES);
+        vector<uint8_t> input(length), serial(length + DES_BLOCK_BYTES), parallel(length + DES_BLOCK_BYTES), back(length + DES_BLOCK_BYTES);
+        uint64_t iv = random();
+        size_t serial_length, back_length;
+        bool passed = true;
+
+        des_fast_key_setup(fast_key_context, random());
+        for (uint8_t& byte : input) {
+            byte = static_cast<uint8_t>(random());
+        }
+
+        des_set_thread_count(1);
+        serial_length = des_mode_encrypt(mode, fast_key_context, iv, input.data(), length, serial.data());
+
+        des_set_thread_count(4);
+        passed = passed && des_mode_encrypt(mode, fast_key_context, iv, input.data(), length, parallel.data()) == serial_length;
+        passed = passed && memcmp(serial.data(), parallel.data(), serial_length) == 0;
+        passed = passed && des_mode_decrypt(mode, fast_key_context, iv, serial.data(), serial_length, back.data(), back_length);
+        passed = passed && back_length == length && memcmp(back.data(), input.data(), length) == 0;
+
+        /* Uneven pieces through the streaming API must match the one-shot result. */
+        des_stream_t stream = { mode, iv };
+        size_t done = 0, blocks = length / DES_BLOCK_BYTES;
+        while (done < blocks) {
+            size_t n = 1 + (random() % 3000);
+            n = (n > blocks - done) ? (blocks - done) : n;
+            des_stream_encrypt_blocks(stream, fast_key_context, input.data() + (done * DES_BLOCK_BYTES), parallel.data() + (done * DES_BLOCK_BYTES), n);
+            done += n;
+        }
+        passed = passed && memcmp(serial.data(), parallel.data(), blocks * DES_BLOCK_BYTES) == 0;
+
+        const char* names[] = { "ECB", "CBC", "CFB", "OFB", "CTR" };
+        check(string("Differential mode ") + names[m] + " serial vs chunked vs threaded", passed, failures);
+    }
+    des_set_thread_count(threads);
+
+    return failures == before;
+}
@@ -0,0 +1,21 @@
+/**
+ ******************************************************************************
+ * \file       des_selftest.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the des self-test
+ * \details    Published DES / 3DES / mode known-answer vectors, plus randomized differential
+ *             testing of every optimized engine against the bitset reference in des.cpp.
+ ******************************************************************************
+*/
+#ifndef DES_SELFTEST_H
+#define	DES_SELFTEST_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des.h"
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Print one line per check and return true when all of them pass. `iterations` random
+ * keys/blocks are used by each differential check. */
+bool des_self_test(const size_t iterations);
+
+#endif	/* DES_SELFTEST_H */
@@ -0,0 +1,585 @@
+/**
+ ******************************************************************************
+ * \file       des_server.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the des socket server and its client
+ ******************************************************************************
+*/
+#include "des_server.h"
+#include "des_thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* Macro Declarations -------------------------------------------------------*/
+/* Latencies are counted in tenths of a microsecond: one bucket per value below 64, then 32
+ * buckets per power of two (about 3% apart) up to 2^40, some 30 hours; anything longer
+ * lands in the last bucket. */
+#define DES_LATENCY_EXACT       64
+#define DES_LATENCY_SUB_BUCKETS 32
+#define DES_LATENCY_BUCKETS     (DES_LATENCY_EXACT + ((40 - 6) * DES_LATENCY_SUB_BUCKETS))
+
+/* Data Type Declarations ---------------------------------------------------*/
+/* A fixed-size log-linear histogram, so a server that reports rarely (or only at exit) keeps
+ * constant memory however many requests it serves. */
+typedef struct {
+    uint64_t counts[DES_LATENCY_BUCKETS];
+    uint64_t count;
+    double max;                 /* microseconds */
+} des_latency_histogram_t;
+
+/* A request waiting for the batching thread. It lives on the stack of its connection thread,
+ * which sleeps until `done` is set; the blocks are processed in place. */
+typedef struct {
+    uint64_t key;
+    bool decrypt;
+    vector<uint64_t> blocks;
+    chrono::steady_clock::time_point received;
+    bool done;
+} des_server_job_t;
+
+typedef struct {
+    mutex lock;
+    condition_variable job_ready, job_done;
+    deque<des_server_job_t*> pending;
+    size_t pending_blocks;
+    bool accepting;
+
+    /* Open client sockets, so they can be shut down to release their threads on exit. */
+    mutex clients_lock;
+    condition_variable clients_done;
+    vector<int> clients;
+} des_server_t;
+
+/* Jobs [first, last) of a sorted batch share a key and direction; their blocks go to
+ * scratch[offset, offset + count) unless the group is a single job. */
+typedef struct {
+    size_t first;
+    size_t last;
+    size_t offset;
+    size_t count;
+} des_server_group_t;
+
+/* Counters since the last report. */
+typedef struct {
+    size_t requests;
+    size_t blocks;
+    size_t batches;
+    uint64_t cache_hits;        /* key cache counters at the last report */
+    uint64_t cache_misses;
+    des_latency_histogram_t latencies;  /* receipt of the request to its result */
+} des_server_stats_t;
+
+/* Variables Definitions ----------------------------------------------------*/
+/* Set by SIGINT / SIGTERM and by a shutdown request; lock-free, so the handler may store it. */
+static atomic<bool> server_stopping(false);
+
+/* Static Functions Declarations --------------------------------------------*/
+static bool recv_all(int fd, void* data, size_t length);
+static bool send_all(int fd, const void* data, size_t length);
+static int connect_socket(const string& socket_path, string& error);
+static void stop_handler(int signal_number);
+static size_t latency_bucket(const double microseconds);
+static double latency_bucket_value(const size_t bucket);
+static void latency_add(des_latency_histogram_t& histogram, const double microseconds);
+static void latency_merge(des_latency_histogram_t& into, const des_latency_histogram_t& from);
+static double percentile(const des_latency_histogram_t& histogram, const double fraction);
+static void print_latencies(const des_latency_histogram_t& latencies);
+static void des_server_connection(des_server_t& server, int fd);
+static void des_server_batcher(des_server_t& server, const double stats_seconds);
+static void des_server_process_batch(vector<des_server_job_t*>& batch, des_key_cache& cache, vector<uint64_t>& scratch, des_server_stats_t& stats);
+static void des_server_process_group(vector<des_server_job_t*>& batch, const des_server_group_t& group, des_key_cache& cache, uint64_t* scratch);
+static void des_server_report(des_server_stats_t& stats, const des_key_cache& cache);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_server_run(const string& socket_path, const double stats_seconds, string& error) {
+    des_server_t server;
+    sockaddr_un address = {};
+    struct sigaction action = {};
+    struct stat existing;
+
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        error = socket_path + ": socket path too long";
+        return false;
+    }
+    /* A socket left behind by an earlier run is replaced; anything else is not touched. */
+    if (lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            error = socket_path + ": exists and is not a socket";
+            return false;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+        error = socket_path + ": " + strerror(errno);
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+        return false;
+    }
+
+    action.sa_handler = stop_handler;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    server.pending_blocks = 0;
+    server.accepting = true;
+    server_stopping = false;
+    thread batcher(des_server_batcher, ref(server), stats_seconds);
+
+    cout << "Serving on " << socket_path << "." << endl;
+    while (!server_stopping) {
+        pollfd listener = { listen_fd, POLLIN, 0 };
+
+        /* Wake up regularly to notice a stop request. */
+        if (poll(&listener, 1, 100) <= 0) {
+            continue;
+        }
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        lock_guard<mutex> guard(server.clients_lock);
+        server.clients.push_back(fd);
+        thread(des_server_connection, ref(server), fd).detach();
+    }
+
+    /* The batcher finishes the jobs already queued and refuses new ones; then every client
+     * socket is shut down so the connection threads return from recv. */
+    server.job_ready.notify_all();
+    batcher.join();
+    close(listen_fd);
+    unlink(socket_path.c_str());
+
+    unique_lock<mutex> guard(server.clients_lock);
+    for (int fd : server.clients) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    server.clients_done.wait(guard, [&] { return server.clients.empty(); });
+    return true;
+}
+
+bool des_client_run(const string& socket_path, const des_client_config_t& config, string& error) {
+    vector<uint64_t> keys(config.keys);
+    vector<des_fast_key_t> key_contexts(config.keys);
+    vector<des_latency_histogram_t> latencies(config.connections);
+    vector<thread> connections;
+    mt19937_64 random(0xC11E47ULL);
+    atomic<bool> failed(false);
+    mutex error_lock;
+
+    for (size_t k = 0; k < config.keys; k++) {
+        keys[k] = random();
+        des_fast_key_setup(key_contexts[k], keys[k]);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (size_t c = 0; c < config.connections; c++) {
+        connections.emplace_back([&, c] {
+            mt19937_64 connection_random(c + 1);
+            vector<uint64_t> blocks(config.blocks), expected(config.blocks);
+            string connection_error;
+            int fd = connect_socket(socket_path, connection_error);
+
+            for (size_t r = 0; fd >= 0 && r < config.requests && !failed; r++) {
+                size_t k = connection_random() % config.keys;
+                des_server_request_t request = { static_cast<uint32_t>(connection_random() & 1), static_cast<uint32_t>(config.blocks), keys[k] };
+                des_server_response_t response;
+
+                for (size_t i = 0; i < config.blocks; i++) {
+                    blocks[i] = connection_random();
+                    expected[i] = (request.op == DES_SERVER_DECRYPT) ? des_fast_decrypt_block(blocks[i], key_contexts[k]) : des_fast_encrypt_block(blocks[i], key_contexts[k]);
+                }
+
+                auto sent = chrono::steady_clock::now();
+                if (!send_all(fd, &request, sizeof(request)) || !send_all(fd, blocks.data(), blocks.size() * sizeof(uint64_t))
+                    || !recv_all(fd, &response, sizeof(response))) {
+                    connection_error = "connection lost";
+                    break;
+                }
+                if (response.status != DES_SERVER_OK || response.block_count != config.blocks
+                    || !recv_all(fd, blocks.data(), blocks.size() * sizeof(uint64_t))) {
+                    connection_error = "bad response";
+                    break;
+                }
+                latency_add(latencies[c], chrono::duration<double, micro>(chrono::steady_clock::now() - sent).count());
+
+                if (blocks != expected) {
+                    connection_error = "wrong result from the server";
+                    break;
+                }
+            }
+
+            if (fd >= 0) {
+                close(fd);
+            }
+            if (!connection_error.empty()) {
+                lock_guard<mutex> guard(error_lock);
+                error = connection_error;
+                failed = true;
+            }
+        });
+    }
+    for (thread& connection : connections) {
+        connection.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (failed) {
+        return false;
+    }
+
+    des_latency_histogram_t all = {};
+    for (const des_latency_histogram_t& connection_latencies : latencies) {
+        latency_merge(all, connection_latencies);
+    }
+    cout << all.count << " requests of " << config.blocks << " blocks over " << config.connections << " connection(s) in "
+         << fixed << setprecision(3) << seconds << " s: " << setprecision(0) << all.count / seconds << " requests/s, "
+         << setprecision(1) << (all.count * config.blocks * DES_BLOCK_BYTES) / seconds / 1e6 << " MB/s, all verified." << endl;
+    print_latencies(all);
+    return true;
+}
+
+bool des_client_shutdown(const string& socket_path, string& error) {
+    des_server_request_t request = { DES_SERVER_SHUTDOWN, 0, 0 };
+    des_server_response_t response;
+    int fd = connect_socket(socket_path, error);
+
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = send_all(fd, &request, sizeof(request)) && recv_all(fd, &response, sizeof(response));
+    close(fd);
+    if (!ok) {
+        error = "connection lost";
+    }
+    return ok;
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static bool recv_all(int fd, void* data, size_t length) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+
+    while (length > 0) {
+        ssize_t n = recv(fd, bytes, length, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool send_all(int fd, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    while (length > 0) {
+        ssize_t n = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static int connect_socket(const string& socket_path, string& error) {
+    sockaddr_un address = {};
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        error = socket_path + ": socket path too long";
+        close(fd);
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        error = socket_path + ": " + strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+static void stop_handler(int) {
+    server_stopping = true;
+}
+
+static size_t latency_bucket(const double microseconds) {
+    uint64_t tenths = static_cast<uint64_t>(microseconds * 10);
+
+    if (tenths < DES_LATENCY_EXACT) {
+        return static_cast<size_t>(tenths);
+    }
+
+    /* The top six bits of the value: the power of two picks the row, the next five bits
+     * the bucket inside it. */
+    size_t exponent = 63 - __builtin_clzll(tenths);
+    size_t bucket = DES_LATENCY_EXACT + ((exponent - 6) * DES_LATENCY_SUB_BUCKETS) + ((tenths >> (exponent - 5)) & (DES_LATENCY_SUB_BUCKETS - 1));
+    return (bucket < DES_LATENCY_BUCKETS) ? bucket : DES_LATENCY_BUCKETS - 1;
+}
+
+/* The middle of a bucket, in microseconds. */
+static double latency_bucket_value(const size_t bucket) {
+    if (bucket < DES_LATENCY_EXACT) {
+        return bucket / 10.0;
+    }
+
+    size_t exponent = 6 + ((bucket - DES_LATENCY_EXACT) / DES_LATENCY_SUB_BUCKETS);
+    uint64_t low = static_cast<uint64_t>(DES_LATENCY_SUB_BUCKETS + ((bucket - DES_LATENCY_EXACT) % DES_LATENCY_SUB_BUCKETS)) << (exponent - 5);
+    return (low + ((1ULL << (exponent - 5)) / 2.0)) / 10.0;
+}
+
+static void latency_add(des_latency_histogram_t& histogram, const double microseconds) {
+    histogram.counts[latency_bucket(microseconds)]++;
+    histogram.count++;
+    histogram.max = (microseconds > histogram.max) ? microseconds : histogram.max;
+}
+
+static void latency_merge(des_latency_histogram_t& into, const des_latency_histogram_t& from) {
+    for (size_t i = 0; i < DES_LATENCY_BUCKETS; i++) {
+        into.counts[i] += from.counts[i];
+    }
+    into.count += from.count;
+    into.max = (from.max > into.max) ? from.max : into.max;
+}
+
+/* The bucket holding the sample of rank fraction * count, capped at the largest sample. */
+static double percentile(const des_latency_histogram_t& histogram, const double fraction) {
+    uint64_t rank = static_cast<uint64_t>(fraction * histogram.count), seen = 0;
+
+    for (size_t i = 0; i < DES_LATENCY_BUCKETS; i++) {
+        seen += histogram.counts[i];
+        if (seen > rank) {
+            double value = latency_bucket_value(i);
+            return (value < histogram.max) ? value : histogram.max;
+        }
+    }
+    return histogram.max;
+}
+
+static void print_latencies(const des_latency_histogram_t& latencies) {
+    if (latencies.count == 0) {
+        return;
+    }
+    cout << "Latency (us): p50 " << fixed << setprecision(1) << percentile(latencies, 0.50)
+         << ", p90 " << percentile(latencies, 0.90) << ", p99 " << percentile(latencies, 0.99)
+         << ", p99.9 " << percentile(latencies, 0.999) << ", max " << latencies.max << endl;
+}
+
+static void des_server_connection(des_server_t& server, int fd) {
+    des_server_request_t request;
+
+    while (recv_all(fd, &request, sizeof(request))) {
+        des_server_response_t response = { DES_SERVER_OK, 0 };
+        des_server_job_t job;
+
+        if (request.op == DES_SERVER_SHUTDOWN) {
+            server_stopping = true;
+            send_all(fd, &response, sizeof(response));
+            break;
+        }
+        if ((request.op != DES_SERVER_ENCRYPT && request.op != DES_SERVER_DECRYPT) || request.block_count > DES_SERVER_MAX_BLOCKS) {
+            response.status = DES_SERVER_BAD_REQUEST;
+            send_all(fd, &response, sizeof(response));
+            break;
+        }
+
+        job.key = request.key;
+        job.decrypt = request.op == DES_SERVER_DECRYPT;
+        job.blocks.resize(request.block_count);
+        job.done = false;
+        if (!recv_all(fd, job.blocks.data(), job.blocks.size() * sizeof(uint64_t))) {
+            break;
+        }
+        job.received = chrono::steady_clock::now();
+
+        {
+            unique_lock<mutex> guard(server.lock);
+            if (!server.accepting) {
+                break;
+            }
+            server.pending.push_back(&job);
+            server.pending_blocks += job.blocks.size();
+            server.job_ready.notify_one();
+            server.job_done.wait(guard, [&] { return job.done; });
+        }
+
+        response.block_count = request.block_count;
+        if (!send_all(fd, &response, sizeof(response)) || !send_all(fd, job.blocks.data(), job.blocks.size() * sizeof(uint64_t))) {
+            break;
+        }
+    }
+
+    lock_guard<mutex> guard(server.clients_lock);
+    server.clients.erase(find(server.clients.begin(), server.clients.end(), fd));
+    close(fd);
+    if (server.clients.empty()) {
+        server.clients_done.notify_all();
+    }
+}
+
+static void des_server_batcher(des_server_t& server, const double stats_seconds) {
+    des_key_cache cache(DES_SERVER_CACHE_KEYS);
+    vector<des_server_job_t*> batch;
+    vector<uint64_t> scratch;
+    des_server_stats_t stats = {};
+    auto last_report = chrono::steady_clock::now();
+
+    while (true) {
+        {
+            unique_lock<mutex> guard(server.lock);
+
+            server.job_ready.wait_for(guard, chrono::milliseconds(100), [&] { return !server.pending.empty() || server_stopping; });
+            if (server.pending.empty() && server_stopping) {
+                server.accepting = false;
+                break;
+            }
+            if (!server.pending.empty()) {
+                /* Hold the batch open for the rest of the window unless it is already full. */
+                auto close_at = server.pending.front()->received + chrono::microseconds(DES_SERVER_BATCH_WINDOW_US);
+                server.job_ready.wait_until(guard, close_at, [&] { return server.pending_blocks >= DES_SERVER_BATCH_BLOCKS || server_stopping; });
+
+                batch.assign(server.pending.begin(), server.pending.end());
+                server.pending.clear();
+                server.pending_blocks = 0;
+            }
+        }
+
+        if (!batch.empty()) {
+            des_server_process_batch(batch, cache, scratch, stats);
+            {
+                lock_guard<mutex> guard(server.lock);
+                for (des_server_job_t* job : batch) {
+                    job->done = true;
+                }
+            }
+            server.job_done.notify_all();
+            batch.clear();
+        }
+
+        if (stats_seconds > 0 && chrono::duration<double>(chrono::steady_clock::now() - last_report).count() >= stats_seconds) {
+            des_server_report(stats, cache);
+            last_report = chrono::steady_clock::now();
+        }
+    }
+    des_server_report(stats, cache);
+}
+
+/* Jobs with the same key and direction become one bulk call, so many small requests reach the
+ * bitslice kernels as one large batch. */
+static void des_server_process_batch(vector<des_server_job_t*>& batch, des_key_cache& cache, vector<uint64_t>& scratch, des_server_stats_t& stats) {
+    vector<des_server_group_t> groups;
+    size_t total = 0, gathered = 0;
+
+    sort(batch.begin(), batch.end(), [](const des_server_job_t* a, const des_server_job_t* b) {
+        return (a->key != b->key) ? (a->key < b->key) : (a->decrypt < b->decrypt);
+    });
+
+    for (size_t first = 0, last; first < batch.size(); first = last) {
+        des_server_group_t group = { first, first, gathered, 0 };
+        for (last = first; last < batch.size() && batch[last]->key == batch[first]->key && batch[last]->decrypt == batch[first]->decrypt; last++) {
+            group.count += batch[last]->blocks.size();
+        }
+        group.last = last;
+        total += group.count;
+        gathered += (last - first > 1) ? group.count : 0;
+        groups.push_back(group);
+    }
+    scratch.resize(gathered);
+
+    /* A lone group runs here, its bulk call threading itself when it is large enough. */
+    if (groups.size() > 1 && total >= DES_SERVER_PARALLEL_BLOCKS) {
+        des_default_thread_pool().parallel_for(groups.size(), [&](size_t i) {
+            des_server_process_group(batch, groups[i], cache, scratch.data());
+        });
+    }
+    else {
+        for (const des_server_group_t& group : groups) {
+            des_server_process_group(batch, group, cache, scratch.data());
+        }
+    }
+    stats.blocks += total;
+
+    auto finished = chrono::steady_clock::now();
+    for (des_server_job_t* job : batch) {
+        latency_add(stats.latencies, chrono::duration<double, micro>(finished - job->received).count());
+    }
+    stats.requests += batch.size();
+    stats.batches++;
+}
+
+/* A lone job is processed in place; several are gathered, processed and scattered. The key
+ * cache is shared by the pool threads, which is safe since it locks per shard. */
+static void des_server_process_group(vector<des_server_job_t*>& batch, const des_server_group_t& group, des_key_cache& cache, uint64_t* scratch) {
+    des_fast_key_t key_context;
+    uint64_t* blocks = batch[group.first]->blocks.data();
+
+    cache.get(batch[group.first]->key, key_context);
+
+    if (group.last - group.first > 1) {
+        blocks = scratch + group.offset;
+        for (size_t j = group.first, offset = 0; j < group.last; offset += batch[j]->blocks.size(), j++) {
+            memcpy(blocks + offset, batch[j]->blocks.data(), batch[j]->blocks.size() * sizeof(uint64_t));
+        }
+    }
+    if (batch[group.first]->decrypt) {
+        des_decrypt_blocks(blocks, blocks, group.count, key_context);
+    }
+    else {
+        des_encrypt_blocks(blocks, blocks, group.count, key_context);
+    }
+    if (group.last - group.first > 1) {
+        for (size_t j = group.first, offset = 0; j < group.last; offset += batch[j]->blocks.size(), j++) {
+            memcpy(batch[j]->blocks.data(), blocks + offset, batch[j]->blocks.size() * sizeof(uint64_t));
+        }
+    }
+}
+
+static void des_server_report(des_server_stats_t& stats, const des_key_cache& cache) {
+    uint64_t hits = cache.hits(), misses = cache.misses();
+
+    if (stats.requests == 0) {
+        return;
+    }
+    cout << stats.requests << " requests, " << stats.blocks << " blocks in " << stats.batches << " batches ("
+         << fixed << setprecision(1) << static_cast<double>(stats.requests) / stats.batches << " requests/batch), key cache "
+         << (hits - stats.cache_hits) << " hits / " << (misses - stats.cache_misses) << " misses." << endl;
+    print_latencies(stats.latencies);
+
+    stats = {};
+    stats.cache_hits = hits;
+    stats.cache_misses = misses;
+}
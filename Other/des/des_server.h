@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * \file       des_server.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the des socket server and its client
+ * \details    A long-lived process serving encrypt/decrypt jobs on a Unix domain socket. Every
+ *             connection gets a thread that only moves bytes; one batching thread collects the
+ *             jobs that arrive within a short window, merges the ones sharing a key and
+ *             direction into one bulk call, and takes the key schedules from a cache. The
+ *             client stub drives the server from many connections, checks every answer against
+ *             the local engine and reports round-trip latency percentiles.
+ ******************************************************************************
+*/
+#ifndef DES_SERVER_H
+#define	DES_SERVER_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des_modes.h"
+
+/* Macro Declarations -------------------------------------------------------*/
+/* Largest job accepted in one request: 8 MiB of blocks. */
+#define DES_SERVER_MAX_BLOCKS       (1024 * 1024)
+
+/* A batch is closed this long after its first job arrived, or as soon as it holds this many
+ * blocks, whichever comes first. */
+#define DES_SERVER_BATCH_WINDOW_US  200
+#define DES_SERVER_BATCH_BLOCKS     (64 * 1024)
+
+/* Batches at least this large are spread over the thread pool (--threads): the key groups in
+ * parallel, or the chunks of a lone group. Smaller ones stay on the batching thread. */
+#define DES_SERVER_PARALLEL_BLOCKS  8192
+
+/* Expanded key schedules kept by the server. */
+#define DES_SERVER_CACHE_KEYS       1024
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef enum {
+    DES_SERVER_ENCRYPT,
+    DES_SERVER_DECRYPT,
+    DES_SERVER_SHUTDOWN
+} des_server_op_t;
+
+typedef enum {
+    DES_SERVER_OK,
+    DES_SERVER_BAD_REQUEST
+} des_server_status_t;
+
+/* Wire format, in host byte order since both ends run on the same machine: a request header
+ * followed by block_count 64-bit blocks, answered by a response header followed by the same
+ * number of blocks. */
+typedef struct {
+    uint32_t op;
+    uint32_t block_count;
+    uint64_t key;
+} des_server_request_t;
+
+typedef struct {
+    uint32_t status;
+    uint32_t block_count;
+} des_server_response_t;
+
+typedef struct {
+    size_t requests;            /* requests per connection */
+    size_t blocks;              /* blocks per request */
+    size_t keys;                /* distinct keys the requests draw from */
+    size_t connections;
+} des_client_config_t;
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Serve on socket_path until SIGINT, SIGTERM or a shutdown request. Latency percentiles and
+ * batching statistics are printed every stats_seconds (0: only at exit). */
+bool des_server_run(const string& socket_path, const double stats_seconds, string& error);
+
+/* Load the server with random requests and verify every answer; returns false on a connection
+ * failure or a wrong block. */
+bool des_client_run(const string& socket_path, const des_client_config_t& config, string& error);
+bool des_client_shutdown(const string& socket_path, string& error);
+
+#endif	/* DES_SERVER_H */
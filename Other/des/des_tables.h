@@ -1,15 +1,22 @@
 /**
  ******************************************************************************
- * @file       des_tables.cpp
+ * @file       des_tables.h
  * @author     Abdulrhman Bahaa
- * @brief      This source file contains implementations for the des tables 
+ * @brief      This header file contains the constexpr definitions of the des tables
+ * @details    The tables are constexpr so every table derived from them (SP boxes, byte
+ *             permutation tables, key rotations, bitslice P wiring) is built by the
+ *             compiler and costs nothing at startup.
  * @date       2025-05-11
  ******************************************************************************
 */
-#include "des.h"
+#ifndef DES_TABLES_H
+#define	DES_TABLES_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cstdint>
 
 /* Variables Definitions ----------------------------------------------------*/
-const uint8_t PC1[64] = {
+inline constexpr uint8_t PC1[56] = {
     57, 49, 41, 33, 25, 17, 9,
     1, 58, 50, 42, 34, 26, 18,
     10, 2, 59, 51, 43, 35, 27,
@@ -20,12 +27,12 @@ const uint8_t PC1[64] = {
     21, 13, 5, 28, 20, 12, 4
 };
 
-const uint8_t ITERATIONS_LEFT_SHIFT[16] = {
+inline constexpr uint8_t ITERATIONS_LEFT_SHIFT[16] = {
     1, 1, 2, 2, 2, 2, 2, 2,
     1, 2, 2, 2, 2, 2, 2, 1
 };
 
-const uint8_t PC2[48] = {
+inline constexpr uint8_t PC2[48] = {
     14, 17, 11, 24, 1, 5,
     3, 28, 15, 6, 21, 10,
     23, 19, 12, 4, 26, 8,
@@ -36,7 +43,7 @@ const uint8_t PC2[48] = {
     46, 42, 50, 36, 29, 32
 };
 
-const uint8_t IP[64] = {
+inline constexpr uint8_t IP[64] = {
     58, 50, 42, 34, 26, 18, 10, 2,
     60, 52, 44, 36, 28, 20, 12, 4,
     62, 54, 46, 38, 30, 22, 14, 6,
@@ -47,7 +54,7 @@ const uint8_t IP[64] = {
     63, 55, 47, 39, 31, 23, 15, 7
 };
 
-const uint8_t IP_INV[64] = {
+inline constexpr uint8_t IP_INV[64] = {
     40, 8, 48, 16, 56, 24, 64, 32,
     39, 7, 47, 15, 55, 23, 63, 31,
     38, 6, 46, 14, 54, 22, 62, 30,
@@ -57,7 +64,7 @@ const uint8_t IP_INV[64] = {
     34, 2, 42, 10, 50, 18, 58, 26,
     33, 1, 41, 9, 49, 17, 57, 25
 };
-const uint8_t E[48] = {
+inline constexpr uint8_t E[48] = {
     32, 1, 2, 3, 4, 5,
     4, 5, 6, 7, 8, 9,
     8, 9, 10, 11, 12, 13,
@@ -68,7 +75,7 @@ const uint8_t E[48] = {
     28, 29 ,30 ,31 ,32 ,1
 };
 
-const uint8_t S_BOXES[8][4][16] = {
+inline constexpr uint8_t S_BOXES[8][4][16] = {
     // S1
     {
         {14,  4, 13,  1,  2, 15, 11,  8,  3, 10,  6, 12,  5,  9,  0,  7},
@@ -127,12 +134,11 @@ const uint8_t S_BOXES[8][4][16] = {
     }
 };
 
-const uint8_t P[32] = {
+inline constexpr uint8_t P[32] = {
     16,  7, 20, 21, 29, 12, 28, 17,
     1, 15, 23, 26, 5, 18, 31, 10,
     2, 8, 24, 14, 32, 27, 3, 9,
     19, 13, 30, 6, 22, 11, 4 ,25
 };
 
-
-
+#endif	/* DES_TABLES_H */
@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * \file       des_thread_pool.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the implementation of the work-stealing thread pool
+ ******************************************************************************
+*/
+#include "des_thread_pool.h"
+
+/* Variables Definitions ----------------------------------------------------*/
+static mutex default_pool_lock;
+static unique_ptr<des_thread_pool> default_pool;
+static size_t default_thread_count = 1;
+static thread_local bool inside_task = false;
+
+/* Function Definitions -----------------------------------------------------*/
+des_thread_pool::des_thread_pool(size_t thread_count) : job(nullptr), generation(0), remaining(0), stopping(false) {
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        queues.emplace_back(new task_queue_t);
+    }
+
+    /* Queue 0 belongs to whichever thread calls parallel_for. */
+    for (size_t i = 1; i < thread_count; i++) {
+        workers.emplace_back(&des_thread_pool::worker_loop, this, i);
+    }
+}
+
+des_thread_pool::~des_thread_pool() {
+    {
+        lock_guard<mutex> guard(job_lock);
+        stopping = true;
+    }
+    job_ready.notify_all();
+
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t des_thread_pool::size() const {
+    return queues.size();
+}
+
+void des_thread_pool::parallel_for(size_t count, const function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (queues.size() == 1 || count == 1 || inside_task) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    lock_guard<mutex> submit_guard(submit_lock);
+    {
+        lock_guard<mutex> guard(job_lock);
+        job = &task;
+        remaining.store(count);
+
+        for (size_t i = 0; i < count; i++) {
+            task_queue_t& queue = *queues[i % queues.size()];
+            lock_guard<mutex> queue_guard(queue.lock);
+            queue.tasks.push_back(i);
+        }
+        generation++;
+    }
+    job_ready.notify_all();
+
+    run_tasks(0);
+
+    unique_lock<mutex> guard(job_lock);
+    job_done.wait(guard, [this] { return remaining.load() == 0; });
+    job = nullptr;
+}
+
+void des_thread_pool::worker_loop(size_t index) {
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            unique_lock<mutex> guard(job_lock);
+            job_ready.wait(guard, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        run_tasks(index);
+    }
+}
+
+void des_thread_pool::run_tasks(size_t index) {
+    size_t task;
+
+    inside_task = true;
+    while (take_task(index, task)) {
+        (*job)(task);
+
+        if (remaining.fetch_sub(1) == 1) {
+            lock_guard<mutex> guard(job_lock);
+            job_done.notify_all();
+        }
+    }
+    inside_task = false;
+}
+
+bool des_thread_pool::take_task(size_t index, size_t& task) {
+    /* Own queue first, newest task first... */
+    {
+        task_queue_t& own = *queues[index];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    /* ...then steal the oldest task of the next non-empty queue. */
+    for (size_t i = 1; i < queues.size(); i++) {
+        task_queue_t& victim = *queues[(index + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void des_set_thread_count(size_t thread_count) {
+    lock_guard<mutex> guard(default_pool_lock);
+
+    if (thread_count == 0) {
+        thread_count = thread::hardware_concurrency();
+    }
+    default_thread_count = (thread_count == 0) ? 1 : thread_count;
+    default_pool.reset();
+}
+
+size_t des_get_thread_count() {
+    lock_guard<mutex> guard(default_pool_lock);
+    return default_thread_count;
+}
+
+des_thread_pool& des_default_thread_pool() {
+    lock_guard<mutex> guard(default_pool_lock);
+
+    if (!default_pool) {
+        default_pool.reset(new des_thread_pool(default_thread_count));
+    }
+    return *default_pool;
+}
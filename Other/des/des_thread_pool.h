@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * \file       des_thread_pool.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains declarations for the work-stealing thread pool
+ * \details    parallel_for() deals task indices round-robin into one deque per worker. A
+ *             worker drains its own deque from the back and, once empty, steals from the
+ *             front of the others, so uneven chunks still keep every core busy.
+ ******************************************************************************
+*/
+#ifndef DES_THREAD_POOL_H
+#define	DES_THREAD_POOL_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* Data Type Declarations ---------------------------------------------------*/
+class des_thread_pool {
+public:
+    /* thread_count includes the calling thread, which works on its own jobs. */
+    explicit des_thread_pool(size_t thread_count);
+    ~des_thread_pool();
+
+    size_t size() const;
+
+    /* Run task(i) for every i in [0, count) and return once all of them finished. Calls from
+     * several threads are serialised; calls from inside a task run inline. */
+    void parallel_for(size_t count, const function<void(size_t)>& task);
+
+private:
+    typedef struct {
+        mutex lock;
+        deque<size_t> tasks;
+    } task_queue_t;
+
+    vector<unique_ptr<task_queue_t>> queues;
+    vector<thread> workers;
+    mutex submit_lock, job_lock;
+    condition_variable job_ready, job_done;
+    const function<void(size_t)>* job;
+    uint64_t generation;
+    atomic<size_t> remaining;
+    bool stopping;
+
+    void worker_loop(size_t index);
+    void run_tasks(size_t index);
+    bool take_task(size_t index, size_t& task);
+};
+
+/* Functions Declarations ---------------------------------------------------*/
+/* Process-wide pool used by the modes of operation; 1 thread (the default) means serial. */
+void des_set_thread_count(size_t thread_count);
+size_t des_get_thread_count();
+des_thread_pool& des_default_thread_pool();
+
+#endif	/* DES_THREAD_POOL_H */
@@ -0,0 +1,173 @@
+/**
+ ******************************************************************************
+ * \file       des_trace.cpp
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the rendering of recorded des traces
+ ******************************************************************************
+*/
+#include "des_trace.h"
+#include <iomanip>
+#include <sstream>
+
+/* Static Functions Declarations --------------------------------------------*/
+static void render_text(const des_record_trace_t& trace, ostream& out);
+static void render_json(const des_record_trace_t& trace, ostream& out);
+static void render_csv(const des_record_trace_t& trace, ostream& out);
+static string hex_field(const uint64_t value, const uint8_t bits);
+
+/* Function Definitions -----------------------------------------------------*/
+bool des_trace_format_from_string(const string& name, des_trace_format_t& format) {
+    if (name == "text") {
+        format = DES_TRACE_FORMAT_TEXT;
+    }
+    else if (name == "json") {
+        format = DES_TRACE_FORMAT_JSON;
+    }
+    else if (name == "csv") {
+        format = DES_TRACE_FORMAT_CSV;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void des_trace_render(const des_record_trace_t& trace, const des_trace_format_t format, ostream& out) {
+    switch (format) {
+        case DES_TRACE_FORMAT_TEXT:
+            render_text(trace, out);
+            break;
+        case DES_TRACE_FORMAT_JSON:
+            render_json(trace, out);
+            break;
+        case DES_TRACE_FORMAT_CSV:
+            render_csv(trace, out);
+            break;
+    }
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static void render_text(const des_record_trace_t& trace, ostream& out) {
+    for (const des_trace_key_schedule_t& schedule : trace.key_schedules) {
+        out << "\n------------------ Sub Keys Generation -----------------" << endl
+            << "\nKey: " << bitset<64>(schedule.key) << endl
+            << "Permuted Key(PC-1): " << bitset<56>(schedule.pc1_permuted) << endl
+            << "\nSplit into C and D, and apply left shifts:"
+            << "\nC0: " << bitset<28>(schedule.c[0]) << "  D0: " << bitset<28>(schedule.d[0]) << endl;
+
+        for (uint8_t i = 1; i <= DES_ROUNDS; i++) {
+            out << "C" << (int)i << ": " << bitset<28>(schedule.c[i]) << "  D" << (int)i << ": " << bitset<28>(schedule.d[i]) << endl;
+        }
+
+        out << "\nConcatenate C and D and apply PC-2: " << endl;
+
+        for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+            out << "Subkey " << (int)i + 1 << ": " << bitset<48>(schedule.subkeys[i]) << endl;
+        }
+    }
+
+    for (const des_trace_round_t& round : trace.rounds) {
+        int i = round.round, k = round.subkey_index;
+
+        out << rang::fg::cyan << "\n------------------- Round " << i + 1 << " -----------------" << rang::style::reset << endl
+            << "Subkey " << k + 1 << ": " << bitset<48>(round.subkey) << endl;
+
+        out << rang::fg::magenta << "\n---------------- Function f --------------" << rang::style::reset << endl
+            << "Expanded R: " << bitset<48>(round.expanded_r) << endl
+            << "XOR with K: " << bitset<48>(round.xor_result) << endl;
+
+        for (uint8_t s = 0; s < 8; s++) {
+            out << "S" << (int)s + 1 << " Row: " << (int)round.sbox_row[s] << " Column: " << (int)round.sbox_column[s] <<
+            " Value: " << bitset<4>(round.sbox_value[s]) << endl;
+        }
+
+        out << "\nApply the P permutation to the concatenated S-Box result: " << endl;
+
+        out << "f(R" << i + 1 << ", K" << k + 1 << ") = " << bitset<32>(round.f) << endl
+            << "R" << i + 1 << " = " << "L" << i << " + f(R" << i << ", K" << k + 1 << ") = " << bitset<32>(round.r) << endl
+            << "L" << i + 1 << " = " <<  "R" << i << " = " << bitset<32>(round.l) << endl;
+    }
+}
+
+static void render_json(const des_record_trace_t& trace, ostream& out) {
+    out << "{\"key_schedules\":[";
+    for (size_t n = 0; n < trace.key_schedules.size(); n++) {
+        const des_trace_key_schedule_t& schedule = trace.key_schedules[n];
+
+        out << (n ? "," : "") << "{\"key\":\"" << hex_field(schedule.key, 64)
+            << "\",\"pc1\":\"" << hex_field(schedule.pc1_permuted, 56) << "\",\"c\":[";
+        for (uint8_t i = 0; i <= DES_ROUNDS; i++) {
+            out << (i ? "," : "") << "\"" << hex_field(schedule.c[i], 28) << "\"";
+        }
+        out << "],\"d\":[";
+        for (uint8_t i = 0; i <= DES_ROUNDS; i++) {
+            out << (i ? "," : "") << "\"" << hex_field(schedule.d[i], 28) << "\"";
+        }
+        out << "],\"subkeys\":[";
+        for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+            out << (i ? "," : "") << "\"" << hex_field(schedule.subkeys[i], 48) << "\"";
+        }
+        out << "]}";
+    }
+
+    out << "],\"rounds\":[";
+    for (size_t n = 0; n < trace.rounds.size(); n++) {
+        const des_trace_round_t& round = trace.rounds[n];
+
+        out << (n ? "," : "") << "\n{\"block\":" << n / DES_ROUNDS
+            << ",\"round\":" << (int)round.round + 1
+            << ",\"subkey_index\":" << (int)round.subkey_index + 1
+            << ",\"subkey\":\"" << hex_field(round.subkey, 48)
+            << "\",\"expanded_r\":\"" << hex_field(round.expanded_r, 48)
+            << "\",\"xor\":\"" << hex_field(round.xor_result, 48) << "\",\"sboxes\":[";
+        for (uint8_t s = 0; s < 8; s++) {
+            out << (s ? "," : "") << "{\"row\":" << (int)round.sbox_row[s] << ",\"column\":" << (int)round.sbox_column[s]
+                << ",\"value\":" << (int)round.sbox_value[s] << "}";
+        }
+        out << "],\"f\":\"" << hex_field(round.f, 32)
+            << "\",\"l\":\"" << hex_field(round.l, 32)
+            << "\",\"r\":\"" << hex_field(round.r, 32) << "\"}";
+    }
+    out << "]}" << endl;
+}
+
+static void render_csv(const des_record_trace_t& trace, ostream& out) {
+    /* Key schedule rows leave the round columns empty (block is then the key schedule number)
+     * and round rows leave c and d empty. */
+    out << "record,block,index,subkey_index,subkey,c,d,f,l,r";
+    for (uint8_t s = 1; s <= 8; s++) {
+        out << ",s" << (int)s << "_row,s" << (int)s << "_column,s" << (int)s << "_value";
+    }
+    out << "\n";
+
+    for (size_t n = 0; n < trace.key_schedules.size(); n++) {
+        const des_trace_key_schedule_t& schedule = trace.key_schedules[n];
+
+        for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+            out << "subkey," << n << "," << (int)i + 1 << "," << (int)i + 1 << "," << hex_field(schedule.subkeys[i], 48) << ","
+                << hex_field(schedule.c[i + 1], 28) << "," << hex_field(schedule.d[i + 1], 28) << ",,,";
+            for (uint8_t s = 0; s < 8; s++) {
+                out << ",,,";
+            }
+            out << "\n";
+        }
+    }
+
+    for (size_t n = 0; n < trace.rounds.size(); n++) {
+        const des_trace_round_t& round = trace.rounds[n];
+
+        out << "round," << n / DES_ROUNDS << "," << (int)round.round + 1 << "," << (int)round.subkey_index + 1 << ","
+            << hex_field(round.subkey, 48) << ",,," << hex_field(round.f, 32) << "," << hex_field(round.l, 32) << "," << hex_field(round.r, 32);
+        for (uint8_t s = 0; s < 8; s++) {
+            out << "," << (int)round.sbox_row[s] << "," << (int)round.sbox_column[s] << "," << (int)round.sbox_value[s];
+        }
+        out << "\n";
+    }
+    out.flush();
+}
+
+static string hex_field(const uint64_t value, const uint8_t bits) {
+    ostringstream text;
+    text << "0x" << uppercase << hex << setfill('0') << setw((bits + 3) / 4) << value;
+    return text.str();
+}
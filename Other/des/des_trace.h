@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ * \file       des_trace.h
+ * \author     Abdulrhman Bahaa
+ * \brief      This source file contains the step tracing policies of the reference des
+ * \details    The reference functions in des.cpp are templates over a trace policy and call
+ *             its hooks at every step. des_no_trace_t has empty inline hooks, so the
+ *             production instantiation has no tracing code or branches left in it.
+ *             des_record_trace_t copies each step into fixed-size records in memory; they
+ *             are formatted as colored text, JSON or CSV only once the work is done.
+ ******************************************************************************
+*/
+#ifndef DES_TRACE_H
+#define	DES_TRACE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "des.h"
+#include <vector>
+
+/* Data Type Declarations ---------------------------------------------------*/
+typedef enum {
+    DES_TRACE_FORMAT_TEXT,
+    DES_TRACE_FORMAT_JSON,
+    DES_TRACE_FORMAT_CSV
+} des_trace_format_t;
+
+/* One expanded key: C0..C16 / D0..D16 and the 16 subkeys (bit 1 is the MSB of each field). */
+typedef struct {
+    uint64_t key;
+    uint64_t pc1_permuted;
+    uint32_t c[DES_ROUNDS + 1];
+    uint32_t d[DES_ROUNDS + 1];
+    uint64_t subkeys[DES_ROUNDS];
+} des_trace_key_schedule_t;
+
+/* One round of one block; rounds of block n are records [16n, 16n + 16). */
+typedef struct {
+    uint64_t subkey;
+    uint64_t expanded_r;
+    uint64_t xor_result;
+    uint32_t f;
+    uint32_t l;
+    uint32_t r;
+    uint8_t round;
+    uint8_t subkey_index;
+    uint8_t sbox_row[8];
+    uint8_t sbox_column[8];
+    uint8_t sbox_value[8];
+} des_trace_round_t;
+
+/* Indices passed to the hooks are zero-based; round is the position in the network and
+ * subkey the schedule entry applied in it (they differ when decrypting). */
+struct des_no_trace_t {
+    void key_schedule_begin(const bitset<64>&, const bitset<56>&, const bitset<28>&, const bitset<28>&) {}
+    void key_shift(uint8_t, const bitset<28>&, const bitset<28>&) {}
+    void key_compression_begin() {}
+    void subkey(uint8_t, const bitset<48>&) {}
+    void round_begin(uint8_t, uint8_t, const bitset<48>&) {}
+    void function_f_begin(const bitset<48>&, const bitset<48>&) {}
+    void sbox(uint8_t, uint8_t, uint8_t, const bitset<4>&) {}
+    void function_f_end() {}
+    void round_end(uint8_t, uint8_t, const bitset<32>&, const bitset<32>&, const bitset<32>&) {}
+};
+
+/* The hooks only fill the current record and append it when it is complete; reserve() up
+ * front keeps a long batch free of reallocations. */
+struct des_record_trace_t {
+    vector<des_trace_key_schedule_t> key_schedules;
+    vector<des_trace_round_t> rounds;
+    des_trace_key_schedule_t current_key_schedule;
+    des_trace_round_t current_round;
+
+    void reserve(size_t key_count, size_t block_count) {
+        key_schedules.reserve(key_count);
+        rounds.reserve(block_count * DES_ROUNDS);
+    }
+
+    void key_schedule_begin(const bitset<64>& key, const bitset<56>& pc1_permuted, const bitset<28>& c, const bitset<28>& d) {
+        current_key_schedule.key = key.to_ullong();
+        current_key_schedule.pc1_permuted = pc1_permuted.to_ullong();
+        current_key_schedule.c[0] = c.to_ulong();
+        current_key_schedule.d[0] = d.to_ulong();
+    }
+    void key_shift(uint8_t i, const bitset<28>& c, const bitset<28>& d) {
+        current_key_schedule.c[i + 1] = c.to_ulong();
+        current_key_schedule.d[i + 1] = d.to_ulong();
+    }
+    void key_compression_begin() {}
+    void subkey(uint8_t i, const bitset<48>& subkey) {
+        current_key_schedule.subkeys[i] = subkey.to_ullong();
+        if (i == DES_ROUNDS - 1) {
+            key_schedules.push_back(current_key_schedule);
+        }
+    }
+    void round_begin(uint8_t round, uint8_t k, const bitset<48>& subkey) {
+        current_round.round = round;
+        current_round.subkey_index = k;
+        current_round.subkey = subkey.to_ullong();
+    }
+    void function_f_begin(const bitset<48>& expanded_r, const bitset<48>& xor_result) {
+        current_round.expanded_r = expanded_r.to_ullong();
+        current_round.xor_result = xor_result.to_ullong();
+    }
+    void sbox(uint8_t i, uint8_t row, uint8_t column, const bitset<4>& value) {
+        current_round.sbox_row[i] = row;
+        current_round.sbox_column[i] = column;
+        current_round.sbox_value[i] = value.to_ulong();
+    }
+    void function_f_end() {}
+    void round_end(uint8_t, uint8_t, const bitset<32>& f, const bitset<32>& l, const bitset<32>& r) {
+        current_round.f = f.to_ulong();
+        current_round.l = l.to_ulong();
+        current_round.r = r.to_ulong();
+        rounds.push_back(current_round);
+    }
+
+    void clear() {
+        key_schedules.clear();
+        rounds.clear();
+    }
+};
+
+/* Functions Declarations ---------------------------------------------------*/
+bool des_trace_format_from_string(const string& name, des_trace_format_t& format);
+
+/* TEXT is the colored --show-steps walkthrough: every key schedule, then every block. */
+void des_trace_render(const des_record_trace_t& trace, const des_trace_format_t format, ostream& out);
+
+#endif	/* DES_TRACE_H */
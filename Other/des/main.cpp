@@ -12,106 +12,677 @@
  * \see     https://page.math.tu-berlin.de/~kant/teaching/hess/krypto-ws2006/des.htm
 */
 #include "des.h"
+#include "des_fast.h"
+#include "des_bitslice.h"
+#include "des_modes.h"
+#include "des_io.h"
+#include "des_thread_pool.h"
+#include "des_key_cache.h"
+#include "des_selftest.h"
+#include "des_trace.h"
+#include "des_search.h"
+#include "des_server.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+/* Static Functions Declarations --------------------------------------------*/
+static void print_usage(const char* program_name);
+static bool parse_hex_bytes(const string& text, vector<uint8_t>& bytes);
+template<typename value_t>
+static bool parse_number(const string& text, const int base, value_t& value);
+static bool parse_seconds(const string& text, double& value);
+static int invalid_value(const char* program_name, const string& flag, ostream& stream);
+static bool parse_key(const string& text, des_fast_key_t& key_context, des3_fast_key_t& key3_context, bool& triple);
+static int run_mode(const string& message, const string& key, const des_mode_t mode, const uint64_t iv, bool decrypt);
+static int run_file(const string& input_path, const string& output_path, const string& key, const des_mode_t mode, const uint64_t iv, bool decrypt);
+static int run_search(int argc, char* argv[]);
+static int run_batch(int argc, char* argv[]);
+static int run_server(int argc, char* argv[]);
+static int run_client(int argc, char* argv[]);
+template<typename trace_t>
+static bitset<64> run_reference(const bitset<64>& message, const bitset<64>& key, des_key_t& key_context, bool decrypt, trace_t& trace);
 
 /* Main Function ------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
 
     /* Variable Declarations */
-    bool show_steps = false;
-    bitset<64> message, key, ciphertext, r_16_l_16_concatenated, ip_permuted;
-    bitset<48>* subkeys = nullptr;
-    bitset<32> l[DES_ROUNDS], r[DES_ROUNDS], function_f_result;
+    bool show_steps = false, decrypt = false, use_mode = false;
+    bool file_mode = (argc > 1) && (string(argv[1]) == "--file");
+    int first_flag = file_mode ? 5 : 3;
+    string engine;
+    des_mode_t mode = DES_MODE_ECB;
+    des_trace_format_t trace_format = DES_TRACE_FORMAT_TEXT;
+    uint64_t iv = 0, message = 0, key = 0, result = 0;
+    des_key_t key_context;
+    des_fast_key_t fast_key_context;
+
+    if (argc > 1 && string(argv[1]) == "--self-test") {
+        size_t iterations = 1000;
+        if (argc > 2 && !parse_number(argv[2], 10, iterations)) {
+            return invalid_value(argv[0], "--self-test", cout);
+        }
+        return des_self_test(iterations) ? 0 : 1;
+    }
+
+    if (argc > 1 && string(argv[1]) == "--search") {
+        return run_search(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return run_batch(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--server") {
+        return run_server(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--client") {
+        return run_client(argc, argv);
+    }
 
     /* Check the number of arguments and their validity. */
-    if (argc != 3 && argc != 4) {
-        cout << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl
-             << "Usage: " << argv[0] << " <message>" << " <key>" << " --show-steps(optional, default: false)" << endl;
+    if (argc < first_flag) {
+        cout << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl;
+        print_usage(argv[0]);
         return 1;
     }
     else {
-        if (argc == 4) {
-            if (string(argv[3]) == "--show-steps") {
+        for (int i = first_flag; i < argc; i++) {
+            if (string(argv[i]) == "--show-steps") {
                 show_steps = true;
-                cout << "Debug mode enabled." << endl;
+            }
+            else if (string(argv[i]) == "--trace-format" && i + 1 < argc) {
+                if (!des_trace_format_from_string(argv[++i], trace_format)) {
+                    cout << rang::fg::red << "Error: Invalid trace format. Use text, json or csv." << rang::style::reset << endl;
+                    return 1;
+                }
+            }
+            else if (string(argv[i]) == "--decrypt") {
+                decrypt = true;
+            }
+            else if (string(argv[i]) == "--engine" && i + 1 < argc) {
+                engine = argv[++i];
+                if (engine != "reference" && engine != "fast" && engine != "bitslice" && engine != "ct") {
+                    cout << rang::fg::red << "Error: Invalid engine. Use fast, bitslice, ct or reference." << rang::style::reset << endl;
+                    return 1;
+                }
+            }
+            else if (string(argv[i]) == "--mode" && i + 1 < argc) {
+                use_mode = true;
+                if (!des_mode_from_string(argv[++i], mode)) {
+                    cout << rang::fg::red << "Error: Invalid mode. Use ecb, cbc, cfb, ofb or ctr." << rang::style::reset << endl;
+                    return 1;
+                }
+            }
+            else if (string(argv[i]) == "--iv" && i + 1 < argc) {
+                if (!parse_number(argv[++i], 16, iv)) {
+                    return invalid_value(argv[0], "--iv", cout);
+                }
+            }
+            else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+                /* 0 means one thread per hardware thread. */
+                size_t thread_count;
+                if (!parse_number(argv[++i], 10, thread_count)) {
+                    return invalid_value(argv[0], "--threads", cout);
+                }
+                des_set_thread_count(thread_count);
             }
             else {
-                cout << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl
-                     << "Usage: " << argv[0] << " <message>" << " <key>" << " --show-steps(optional, default: false)" << endl;
+                cout << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl;
+                print_usage(argv[0]);
                 return 1;
             }
         }
 
+        if (file_mode) {
+            return run_file(argv[2], argv[3], argv[4], mode, iv, decrypt);
+        }
+
+        if (use_mode) {
+            return run_mode(argv[1], argv[2], mode, iv, decrypt);
+        }
+
         switch(argv[1][1]) {
             case 'x':
-                message = bitset<64>(stoull(argv[1] + 2, nullptr, 16));
-                key = bitset<64>(stoull(argv[2] + 2, nullptr, 16));
+                message = stoull(argv[1] + 2, nullptr, 16);
+                key = stoull(argv[2] + 2, nullptr, 16);
                 break;
             case 'd':
-                message = bitset<64>(stoull(argv[1] + 2, nullptr, 10));
-                key = bitset<64>(stoull(argv[2] + 2, nullptr, 10));
+                message = stoull(argv[1] + 2, nullptr, 10);
+                key = stoull(argv[2] + 2, nullptr, 10);
                 break;
             case 'b':
-                message = bitset<64>(stoull(argv[1] + 2, nullptr, 2));
-                key = bitset<64>(stoull(argv[2] + 2, nullptr, 2));
+                message = stoull(argv[1] + 2, nullptr, 2);
+                key = stoull(argv[2] + 2, nullptr, 2);
                 break;
             default:
                 cout << rang::fg::red << "Error: Invalid message/key format. Use 0x, 0d or 0b." << rang::style::reset << endl;
                 return 1;
         }
 
-        if (message.size() != 64 || key.size() != 64) {
-            cout << rang::fg::red << "Error: Message and key must be 64 bits long." << rang::style::reset << endl;
+        /* The packed-integer engine is the default; the bitset engine is the reference and
+         * the only one that can show its steps. */
+        if (engine.empty()) {
+            engine = show_steps ? "reference" : "fast";
+        }
+
+        if (show_steps && engine != "reference") {
+            cout << rang::fg::red << "Error: --show-steps is only available with the reference engine." << rang::style::reset << endl;
             return 1;
         }
+
+        if (show_steps && trace_format == DES_TRACE_FORMAT_TEXT) {
+            cout << "Debug mode enabled." << endl;
+        }
     }
 
+    if (engine == "fast") {
+        des_fast_key_setup(fast_key_context, key);
+
+        if (decrypt) {
+            result = des_fast_decrypt_block(message, fast_key_context);
+        }
+        else {
+            result = des_fast_encrypt_block(message, fast_key_context);
+        }
+
+        print_block(message, key, result, decrypt);
+        return 0;
+    }
+
+    if (engine == "bitslice" || engine == "ct") {
+        /* The constant-time engine: no table lookup anywhere, including the key schedule. */
+        if (engine == "ct") {
+            des_fast_key_setup_ct(fast_key_context, key);
+        }
+        else {
+            des_fast_key_setup(fast_key_context, key);
+        }
+
+        if (decrypt) {
+            des_bitslice_decrypt_blocks(&message, &result, 1, fast_key_context);
+        }
+        else {
+            des_bitslice_encrypt_blocks(&message, &result, 1, fast_key_context);
+        }
+
+        print_block(message, key, result, decrypt);
+        return 0;
+    }
+
+    /* Tracing is a separate instantiation; the untraced path carries no tracing code. The
+     * steps are recorded while the block runs and only formatted afterwards. */
+    if (show_steps) {
+        des_record_trace_t trace;
+        trace.reserve(1, 1);
+        result = run_reference(message, key, key_context, decrypt, trace).to_ullong();
+        des_trace_render(trace, trace_format, cout);
+
+        if (trace_format != DES_TRACE_FORMAT_TEXT) {
+            return 0;
+        }
+    }
+    else {
+        des_no_trace_t trace;
+        result = run_reference(message, key, key_context, decrypt, trace).to_ullong();
+    }
+
+    /* Print the block. */
+    print_block(message, key, result, decrypt);
+
+    return 0;
+}
+
+/* Static Functions Definitions ---------------------------------------------*/
+static void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " <message>" << " <key>"
+         << " --decrypt(optional, default: false)"
+         << " --engine <fast|bitslice|ct|reference>(optional, default: fast, reference with --show-steps)"
+         << " --mode <ecb|cbc|cfb|ofb|ctr>(optional, hex message of any length)"
+         << " --iv <hex>(optional, default: 0)"
+         << " --show-steps(optional, default: false)"
+         << " --trace-format <text|json|csv>(optional, default: text)" << endl
+         << "       " << program_name << " --file <input|-> <output|-> <key>"
+         << " --mode <ecb|cbc|cfb|ofb|ctr>(optional, default: ecb)"
+         << " --iv <hex>(optional, default: 0)"
+         << " --threads <n>(optional, default: 1, 0: all cores)"
+         << " --decrypt(optional, default: false)" << endl
+         << "       " << program_name << " --batch <input|-> <output|-> <key|->(-: a key on every line)"
+         << " --input-format <hex|base64|raw>(optional, default: hex)"
+         << " --output-format <hex|base64|raw>(optional, default: hex)"
+         << " --key-cache <entries>(optional, per-line keys only, default: off)"
+         << " --threads <n>(optional, default: 1, 0: all cores)"
+         << " --decrypt(optional, default: false)" << endl
+         << "       " << program_name << " --server <socket>"
+         << " --stats <seconds>(optional, default: 10, 0: only at exit)"
+         << " --threads <n>(optional, default: 1, 0: all cores)" << endl
+         << "       " << program_name << " --client <socket>"
+         << " --requests <n>(optional, per connection, default: 1000)"
+         << " --blocks <n>(optional, per request, default: 16)"
+         << " --keys <n>(optional, default: 8)"
+         << " --connections <n>(optional, default: 4)"
+         << " --shutdown(optional, stop the server instead)" << endl
+         << "       " << program_name << " --search <plaintext> <ciphertext>"
+         << " --mask <hex>(optional, default: all 56 key bits)"
+         << " --base <hex>(optional, key bits outside the mask, default: 0)"
+         << " --start <hex>(optional) --end <hex>(optional, key index range)"
+         << " --complement <hex>(optional, ciphertext of the complemented plaintext)"
+         << " --checkpoint <file>(optional)"
+         << " --threads <n>(optional, default: 1, 0: all cores)" << endl
+         << "       " << program_name << " --self-test <iterations>(optional, default: 1000)" << endl;
+}
+
+template<typename trace_t>
+static bitset<64> run_reference(const bitset<64>& message, const bitset<64>& key, des_key_t& key_context, bool decrypt, trace_t& trace) {
     /* Step 1: Create 16 subkeys, each of which is 48-bits long. */
-    subkeys = sub_key_generator(key, show_steps);
+    /* The same key context serves both directions; decryption walks it backwards. */
+    des_key_setup(key_context, key, trace);
+
+    /* Step 2: Encode (or decode) each 64-bit block of data. */
+    if (decrypt) {
+        return des_decrypt_block(message, key_context, trace);
+    }
+    return des_encrypt_block(message, key_context, trace);
+}
+
+static bool parse_hex_bytes(const string& text, vector<uint8_t>& bytes) {
+    if (text.size() < 2 || text[0] != '0' || text[1] != 'x' || (text.size() % 2) != 0) {
+        return false;
+    }
+
+    bytes.clear();
+    for (size_t i = 2; i < text.size(); i += 2) {
+        if (!isxdigit(static_cast<unsigned char>(text[i])) || !isxdigit(static_cast<unsigned char>(text[i + 1]))) {
+            return false;
+        }
+        bytes.push_back(static_cast<uint8_t>(stoul(text.substr(i, 2), nullptr, 16)));
+    }
+    return true;
+}
+
+/* Digits only (a 0x prefix is allowed in base 16): no sign, no spaces, within range of value_t. */
+template<typename value_t>
+static bool parse_number(const string& text, const int base, value_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed;
+
+    if (text.empty() || !isalnum(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    errno = 0;
+    parsed = strtoull(text.c_str(), &end, base);
+    if (errno != 0 || *end != '\0' || parsed > numeric_limits<value_t>::max()) {
+        return false;
+    }
+    value = static_cast<value_t>(parsed);
+    return true;
+}
+
+static bool parse_seconds(const string& text, double& value) {
+    char* end = nullptr;
+
+    if (text.empty() || !isalnum(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    errno = 0;
+    value = strtod(text.c_str(), &end);
+    return errno == 0 && *end == '\0' && isfinite(value);
+}
+
+static int invalid_value(const char* program_name, const string& flag, ostream& stream) {
+    stream << rang::fg::red << "Error: Invalid value for " << flag << "." << rang::style::reset << endl;
+    print_usage(program_name);
+    return 1;
+}
+
+template<typename key_t>
+static bool mode_process(const key_t& key_context, const des_mode_t mode, const uint64_t iv, const vector<uint8_t>& input, vector<uint8_t>& output, size_t& output_length, bool decrypt) {
+    output.resize(input.size() + DES_BLOCK_BYTES);
+
+    if (decrypt) {
+        return des_mode_decrypt(mode, key_context, iv, input.data(), input.size(), output.data(), output_length);
+    }
+    output_length = des_mode_encrypt(mode, key_context, iv, input.data(), input.size(), output.data());
+    return true;
+}
+
+static bool parse_key(const string& text, des_fast_key_t& key_context, des3_fast_key_t& key3_context, bool& triple) {
+    vector<uint8_t> key_bytes;
+
+    /* An 8-byte key selects DES, 16 bytes 3DES EDE2 (K3 = K1) and 24 bytes 3DES EDE3. */
+    if (!parse_hex_bytes(text, key_bytes) || (key_bytes.size() != 8 && key_bytes.size() != 16 && key_bytes.size() != 24)) {
+        return false;
+    }
+
+    triple = key_bytes.size() != DES_BLOCK_BYTES;
+    if (triple) {
+        des3_fast_key_setup(key3_context, load_block(key_bytes.data()), load_block(key_bytes.data() + 8),
+                            load_block(key_bytes.data() + ((key_bytes.size() == 24) ? 16 : 0)));
+    }
+    else {
+        des_fast_key_setup(key_context, load_block(key_bytes.data()));
+    }
+    return true;
+}
+
+static int run_mode(const string& message, const string& key, const des_mode_t mode, const uint64_t iv, bool decrypt) {
+    vector<uint8_t> input, output;
+    des_fast_key_t key_context;
+    des3_fast_key_t key3_context;
+    size_t output_length = 0;
+    bool ok = false, triple = false;
+
+    if (!parse_hex_bytes(message, input) || !parse_key(key, key_context, key3_context, triple)) {
+        cout << rang::fg::red << "Error: With --mode the message must be 0x followed by whole bytes and the key 0x followed by 16, 32 or 48 hex digits." << rang::style::reset << endl;
+        return 1;
+    }
+
+    if (triple) {
+        ok = mode_process(key3_context, mode, iv, input, output, output_length, decrypt);
+    }
+    else {
+        ok = mode_process(key_context, mode, iv, input, output, output_length, decrypt);
+    }
+
+    if (!ok) {
+        cout << rang::fg::red << "Error: Invalid ciphertext length or padding." << rang::style::reset << endl;
+        return 1;
+    }
+
+    cout << rang::fg::cyan << (decrypt ? "Plaintext : " : "Ciphertext: ") << rang::style::reset
+         << rang::fg::green << "0x" << uppercase << hex << setfill('0');
+    for (size_t i = 0; i < output_length; i++) {
+        cout << setw(2) << (int)output[i];
+    }
+    cout << rang::style::reset << dec << endl;
+
+    return 0;
+}
+
+static int run_file(const string& input_path, const string& output_path, const string& key, const des_mode_t mode, const uint64_t iv, bool decrypt) {
+    des_fast_key_t key_context;
+    des3_fast_key_t key3_context;
+    string error;
+    bool ok = false, triple = false;
 
-    /* Step 2: Encode each 64-bit block of data. */
-    /* Apply the initial permutation (IP) to the message.*/ 
-    ip_permuted = permute<64, 64>(message, IP);
+    /* Diagnostics go to stderr: stdout may be carrying the output stream. */
+    if (!parse_key(key, key_context, key3_context, triple)) {
+        cerr << rang::fg::red << "Error: The key must be 0x followed by 16, 32 or 48 hex digits." << rang::style::reset << endl;
+        return 1;
+    }
+
+    if (triple) {
+        ok = des_file_process(input_path, output_path, mode, key3_context, iv, decrypt, error);
+    }
+    else {
+        ok = des_file_process(input_path, output_path, mode, key_context, iv, decrypt, error);
+    }
+
+    if (!ok) {
+        cerr << rang::fg::red << "Error: " << error << rang::style::reset << endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int run_search(int argc, char* argv[]) {
+    des_search_config_t config = {};
+    des_search_result_t result;
+    string error;
+
+    config.mask = DES_SEARCH_KEY_BITS;
 
-    /* Split the permuted message into two halves: left (l) and right (r). */
-    for (uint8_t i = 0; i < 32; ++i) {
-        l[0][31 - i] = ip_permuted[63 - i];
-        r[0][31 - i] = ip_permuted[31 - i];
+    if (argc < 4) {
+        cout << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl;
+        print_usage(argv[0]);
+        return 1;
     }
 
-    /* Apply the 16 rounds of the DES algorithm. */
-    for (uint8_t i = 0; i < DES_ROUNDS; i++) {
+    if (!parse_number(argv[2], 16, config.plaintext)) {
+        return invalid_value(argv[0], "plaintext", cout);
+    }
+    if (!parse_number(argv[3], 16, config.ciphertext)) {
+        return invalid_value(argv[0], "ciphertext", cout);
+    }
 
-        /* Print Debug Information if show_steps is enabled. */
-        if (show_steps) {
-            cout << rang::fg::cyan << "\n------------------- Round " << (int)i + 1 << " -----------------" << rang::style::reset << endl
-                 << "Subkey " << (int)i + 1 << ": " << subkeys[i] << endl;
+    for (int i = 4; i < argc; i++) {
+        if (string(argv[i]) == "--mask" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 16, config.mask)) {
+                return invalid_value(argv[0], "--mask", cout);
+            }
+        }
+        else if (string(argv[i]) == "--base" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 16, config.base_key)) {
+                return invalid_value(argv[0], "--base", cout);
+            }
+        }
+        else if (string(argv[i]) == "--start" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 16, config.start)) {
+                return invalid_value(argv[0], "--start", cout);
+            }
+        }
+        else if (string(argv[i]) == "--end" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 16, config.end)) {
+                return invalid_value(argv[0], "--end", cout);
+            }
+        }
+        else if (string(argv[i]) == "--complement" && i + 1 < argc) {
+            config.use_complement = true;
+            if (!parse_number(argv[++i], 16, config.complement_ciphertext)) {
+                return invalid_value(argv[0], "--complement", cout);
+            }
+        }
+        else if (string(argv[i]) == "--checkpoint" && i + 1 < argc) {
+            config.checkpoint_path = argv[++i];
         }
+        else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+            size_t thread_count;
+            if (!parse_number(argv[++i], 10, thread_count)) {
+                return invalid_value(argv[0], "--threads", cout);
+            }
+            des_set_thread_count(thread_count);
+        }
+        else {
+            cout << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
 
-        function_f_result = function_f(r[i], subkeys[i], show_steps);
-        l[i + 1] = r[i];
-        r[i + 1] = l[i] ^ function_f_result;    /* R1 = L0 + f(R0,K1)  */
+    cout << "Searching with " << des_get_thread_count() << " thread(s), " << des_bitslice_kernel_name(des_bitslice_get_kernel()) << " kernel." << endl;
 
-        if (show_steps) {
-            cout << "f(R" << (int)i + 1 << ", K" << (int)i + 1 << ") = " << function_f_result << endl
-                 << "R" << (int)i + 1 << " = " << "L" << (int)i << " + f(R" << (int)i << ", K" << (int)i + 1 << ") = " << r[i + 1] << endl
-                 << "L" << (int)i + 1 << " = " <<  "R" << (int)i << " = " << l[i + 1] << endl;
+    bool ok = des_key_search(config, result, [](const des_search_result_t& progress) {
+        double done = 100.0 * (progress.next_index - progress.start) / (progress.end - progress.start);
+        cout << "\rIndex 0x" << uppercase << hex << progress.next_index << dec
+             << " (" << fixed << setprecision(2) << done << "%), "
+             << ((progress.seconds > 0) ? progress.keys_tested / progress.seconds / 1e6 : 0.0) << " Mkeys/s   " << flush;
+    }, error);
+    cout << endl;
 
+    if (!ok) {
+        cout << rang::fg::red << "Error: " << error << rang::style::reset << endl;
+        return 1;
+    }
+
+    cout << "Tested " << result.keys_tested << " keys in " << fixed << setprecision(2) << result.seconds << " s ("
+         << ((result.seconds > 0) ? result.keys_tested / result.seconds / 1e6 : 0.0) << " Mkeys/s)." << endl;
+    if (result.found) {
+        cout << rang::fg::green << "Key found: 0x" << uppercase << hex << setfill('0') << setw(16) << result.key << dec << rang::style::reset << endl;
+        return 0;
+    }
+    cout << rang::fg::yellow << "Key not found in the range." << rang::style::reset << endl;
+    return 2;
+}
+
+static int run_batch(int argc, char* argv[]) {
+    des_codec_t input_codec = DES_CODEC_HEX, output_codec = DES_CODEC_HEX;
+    des_fast_key_t key_context;
+    des3_fast_key_t key3_context;
+    bool decrypt = false, triple = false, ok = false;
+    size_t cache_entries = 0;
+    string error;
+
+    /* Diagnostics go to stderr: stdout may be carrying the output stream. */
+    if (argc < 5) {
+        cerr << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 5; i < argc; i++) {
+        if (string(argv[i]) == "--input-format" && i + 1 < argc) {
+            if (!des_codec_from_string(argv[++i], input_codec)) {
+                cerr << rang::fg::red << "Error: Invalid format. Use hex, base64 or raw." << rang::style::reset << endl;
+                return 1;
+            }
+        }
+        else if (string(argv[i]) == "--output-format" && i + 1 < argc) {
+            if (!des_codec_from_string(argv[++i], output_codec)) {
+                cerr << rang::fg::red << "Error: Invalid format. Use hex, base64 or raw." << rang::style::reset << endl;
+                return 1;
+            }
+        }
+        else if (string(argv[i]) == "--decrypt") {
+            decrypt = true;
+        }
+        else if (string(argv[i]) == "--key-cache" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 10, cache_entries)) {
+                return invalid_value(argv[0], "--key-cache", cerr);
+            }
+        }
+        else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+            size_t thread_count;
+            if (!parse_number(argv[++i], 10, thread_count)) {
+                return invalid_value(argv[0], "--threads", cerr);
+            }
+            des_set_thread_count(thread_count);
+        }
+        else {
+            cerr << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl;
+            print_usage(argv[0]);
+            return 1;
         }
     }
 
-    /* Concatenate the last round's right and left halves. */
-    /* The left half (l) is placed in the lower 32 bits, and the right half (r) is placed in the upper 32 bits. */
-    for (uint8_t i = 0; i < 32; i++) {
-        r_16_l_16_concatenated[63 - i] = r[DES_ROUNDS][31 - i];
-        r_16_l_16_concatenated[31 - i] = l[DES_ROUNDS][31 - i];
+    if (string(argv[4]) == "-" && cache_entries > 0) {
+        des_key_cache cache(cache_entries);
+
+        ok = des_batch_process_keyed(argv[2], argv[3], input_codec, output_codec, cache, decrypt, error);
+        cerr << "Key cache: " << cache.hits() << " hits, " << cache.misses() << " misses." << endl;
+    }
+    else if (string(argv[4]) == "-") {
+        ok = des_batch_process_keyed(argv[2], argv[3], input_codec, output_codec, decrypt, error);
+    }
+    else if (!parse_key(argv[4], key_context, key3_context, triple)) {
+        cerr << rang::fg::red << "Error: The key must be 0x followed by 16, 32 or 48 hex digits." << rang::style::reset << endl;
+        return 1;
+    }
+    else if (triple) {
+        ok = des_batch_process(argv[2], argv[3], input_codec, output_codec, key3_context, decrypt, error);
     }
+    else {
+        ok = des_batch_process(argv[2], argv[3], input_codec, output_codec, key_context, decrypt, error);
+    }
+
+    if (!ok) {
+        cerr << rang::fg::red << "Error: " << error << rang::style::reset << endl;
+        return 1;
+    }
+    return 0;
+}
 
-    /* Apply the final permutation (IP-1) to the concatenated result. */
-    ciphertext = permute<64, 64>(r_16_l_16_concatenated, IP_INV);
+static int run_server(int argc, char* argv[]) {
+    double stats_seconds = 10;
+    string error;
 
-    /* Print the block. */
-    print_block(message, key, ciphertext);
+    if (argc < 3) {
+        cout << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
 
+    for (int i = 3; i < argc; i++) {
+        if (string(argv[i]) == "--stats" && i + 1 < argc) {
+            if (!parse_seconds(argv[++i], stats_seconds)) {
+                return invalid_value(argv[0], "--stats", cout);
+            }
+        }
+        else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+            size_t thread_count;
+            if (!parse_number(argv[++i], 10, thread_count)) {
+                return invalid_value(argv[0], "--threads", cout);
+            }
+            des_set_thread_count(thread_count);
+        }
+        else {
+            cout << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!des_server_run(argv[2], stats_seconds, error)) {
+        cout << rang::fg::red << "Error: " << error << rang::style::reset << endl;
+        return 1;
+    }
     return 0;
 }
 
+static int run_client(int argc, char* argv[]) {
+    des_client_config_t config = { 1000, 16, 8, 4 };
+    bool stop_server = false;
+    string error;
+
+    if (argc < 3) {
+        cout << rang::fg::red << "Error: Invalid number of arguments." << rang::style::reset << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 3; i < argc; i++) {
+        if (string(argv[i]) == "--requests" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 10, config.requests)) {
+                return invalid_value(argv[0], "--requests", cout);
+            }
+        }
+        else if (string(argv[i]) == "--blocks" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 10, config.blocks)) {
+                return invalid_value(argv[0], "--blocks", cout);
+            }
+        }
+        else if (string(argv[i]) == "--keys" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 10, config.keys)) {
+                return invalid_value(argv[0], "--keys", cout);
+            }
+        }
+        else if (string(argv[i]) == "--connections" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 10, config.connections)) {
+                return invalid_value(argv[0], "--connections", cout);
+            }
+        }
+        else if (string(argv[i]) == "--shutdown") {
+            stop_server = true;
+        }
+        else {
+            cout << rang::fg::red << "Error: Invalid flag." << rang::style::reset << endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.keys == 0 || config.connections == 0 || config.blocks > DES_SERVER_MAX_BLOCKS) {
+        cout << rang::fg::red << "Error: Need at least one key and one connection, and at most " << DES_SERVER_MAX_BLOCKS << " blocks per request." << rang::style::reset << endl;
+        return 1;
+    }
+
+    bool ok = stop_server ? des_client_shutdown(argv[2], error) : des_client_run(argv[2], config, error);
+    if (!ok) {
+        cout << rang::fg::red << "Error: " << error << rang::style::reset << endl;
+        return 1;
+    }
+    return 0;
+}